@@ -0,0 +1,431 @@
+// Benchmark for the Pokedex engine: runs a reproducible mix of operations against the
+// functions in ex6.c and reports ops/sec and p50/p99 latency per operation type.
+//
+//   gcc -O2 -std=c99 -pthread bench.c -o bench
+//   ./bench [-o owners] [-n operations] [-s seed] [-d uniform|sequential|skewed] > /dev/null
+//
+// Results go to stderr; stdout gets whatever the operations print (fights, displays, sort).
+// Afterwards every owner's tree is copied into a CompactPokedex, checked against the tree,
+// and both are timed on the same random lookups. Last, the owners are topped up to at least
+// two league threads' worth and the league standings from several threads are checked
+// against a single-threaded run.
+
+#define _POSIX_C_SOURCE 200809L
+#define EX6_NO_MAIN
+#include "ex6.c"
+
+#include <time.h>
+
+typedef enum
+{
+    BENCH_ADD,
+    BENCH_RELEASE,
+    BENCH_EVOLVE,
+    BENCH_FIGHT,
+    BENCH_DISPLAY,
+    BENCH_MERGE,
+    BENCH_SORT,
+    BENCH_OP_COUNT
+} BenchOp;
+
+// name and share (out of 1000) of each operation in the mix, in BenchOp order
+static const struct
+{
+    const char *name;
+    int weight;
+} benchMix[BENCH_OP_COUNT] = {
+    {"add", 450}, {"release", 200}, {"evolve", 150}, {"fight", 100},
+    {"display", 60}, {"merge", 39}, {"sort", 1}};
+
+typedef enum
+{
+    IDS_UNIFORM,
+    IDS_SEQUENTIAL,
+    IDS_SKEWED
+} IdDistribution;
+
+static uint64_t rngState;
+
+/**xorshift64*, so a seed always gives the same workload*/
+static uint64_t nextRandom(void)
+{
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return rngState * 2685821657736338717ULL;
+}
+
+/**random int in [0, bound)*/
+static int randomBelow(int bound)
+{
+    return (int)(nextRandom() % (uint64_t)bound);
+}
+
+/**next species ID for this owner: uniform, ascending per owner (worst case for a plain BST),
+   or skewed towards low IDs*/
+static int nextId(IdDistribution distribution, int *sequence)
+{
+    switch (distribution)
+    {
+    case IDS_SEQUENTIAL:
+        *sequence = *sequence % MAX_POKEMON_ID + 1;
+        return *sequence;
+    case IDS_SKEWED:
+    {
+        int a = randomBelow(MAX_POKEMON_ID);
+        int b = randomBelow(MAX_POKEMON_ID);
+        return (a < b ? a : b) + 1;
+    }
+    default:
+        return randomBelow(MAX_POKEMON_ID) + 1;
+    }
+}
+
+static uint64_t nowNanos(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int compareNanos(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**creates owner number serial with a starter picked from it and returns it*/
+static OwnerNode *benchOwner(int serial)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "trainer%07d", serial);
+    if (applyNewOwner(name, serial % 3 + 1) != OP_OK)
+        return NULL;
+    return findOwnerByName(name);
+}
+
+/**returns 1 if the compact copy holds exactly the tree's IDs, both ways round*/
+static int compactMatchesTree(const CompactPokedex *compact, OwnerNode *owner)
+{
+    PokemonNode *nodes[MAX_POKEMON_ID];
+    uint8_t ids[MAX_POKEMON_ID];
+    int count = flattenPokedex(owner->pokedexRoot, nodes);
+    if (compactIds(compact, ids) != count)
+        return 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (ids[i] != nodes[i]->data->id)
+            return 0;
+    }
+    for (int id = 0; id <= MAX_POKEMON_ID + 1; id++)
+    {
+        if (compactContains(compact, id) != ownsPokemon(owner, id))
+            return 0;
+    }
+    // and back: the expanded tree has the same IDs in the same order
+    PokemonArena scratch;
+    initPokemonArena(&scratch);
+    PokemonNode *expanded[MAX_POKEMON_ID];
+    int same = flattenPokedex(compactToTree(compact, &scratch), expanded) == count;
+    for (int i = 0; same && i < count; i++)
+        same = expanded[i]->data == nodes[i]->data;
+    destroyPokemonArena(&scratch);
+    return same;
+}
+
+/**copies every owner into a CompactPokedex, checks the copies, and times lookups in both; returns 0 on a mismatch*/
+static int benchCompact(OwnerNode **owners, int ownerCount, long lookups)
+{
+    CompactPokedex *compact = calloc(ownerCount, sizeof(CompactPokedex));
+    int *lookupOwner = malloc(sizeof(int) * lookups);
+    int *lookupId = malloc(sizeof(int) * lookups);
+    if (compact == NULL || lookupOwner == NULL || lookupId == NULL)
+    {
+        fprintf(stderr, "Memory allocation failed.\n");
+        free(compact);
+        free(lookupOwner);
+        free(lookupId);
+        return 0;
+    }
+    long nodes = 0;
+    int ok = 1;
+    for (int i = 0; i < ownerCount && ok; i++)
+    {
+        ok = compactFromTree(&compact[i], owners[i]->pokedexRoot) && compactMatchesTree(&compact[i], owners[i]);
+        nodes += compact[i].count;
+    }
+    if (!ok)
+        fprintf(stderr, "compact: copy does not match the tree\n");
+
+    for (long n = 0; n < lookups; n++)
+    {
+        lookupOwner[n] = randomBelow(ownerCount);
+        lookupId[n] = randomBelow(MAX_POKEMON_ID) + 1;
+    }
+    long treeHits = 0, compactHits = 0;
+    uint64_t start = nowNanos();
+    for (long n = 0; n < lookups; n++)
+        treeHits += searchPokemonBST(owners[lookupOwner[n]]->pokedexRoot, lookupId[n]) != NULL;
+    uint64_t treeNanos = nowNanos() - start;
+    start = nowNanos();
+    for (long n = 0; n < lookups; n++)
+        compactHits += compactContains(&compact[lookupOwner[n]], lookupId[n]);
+    uint64_t compactNanos = nowNanos() - start;
+    if (ok && treeHits != compactHits)
+    {
+        fprintf(stderr, "compact: %ld hits, tree: %ld hits\n", compactHits, treeHits);
+        ok = 0;
+    }
+
+    fprintf(stderr, "\n%-8s %12s %14s %10s\n", "layout", "node bytes", "total bytes", "lookup ns");
+    fprintf(stderr, "%-8s %12zu %14ld %10.1f\n", "tree", sizeof(PokemonNode),
+            nodes * (long)sizeof(PokemonNode), (double)treeNanos / lookups);
+    fprintf(stderr, "%-8s %12zu %14ld %10.1f\n", "compact", sizeof(CompactNode),
+            nodes * (long)sizeof(CompactNode), (double)compactNanos / lookups);
+
+    for (int i = 0; i < ownerCount; i++)
+        freeCompactPokedex(&compact[i]);
+    free(compact);
+    free(lookupOwner);
+    free(lookupId);
+    return ok;
+}
+
+/**tops the ring up to at least two threads' worth of owners, ranks the league on several threads and on one,
+ * and returns 0 if the two standings differ*/
+static int benchLeague(int *nextSerial)
+{
+    // owners beyond the mix get a few random Pokemon so strengths spread out but still tie often
+    while (ownersAmount() < 2 * LEAGUE_OWNERS_PER_THREAD)
+    {
+        OwnerNode *owner = benchOwner((*nextSerial)++);
+        if (owner == NULL)
+        {
+            fprintf(stderr, "Memory allocation failed.\n");
+            return 0;
+        }
+        for (int n = randomBelow(8); n > 0; n--)
+            applyAddPokemon(owner, randomBelow(MAX_POKEMON_ID) + 1);
+    }
+    int count = ownersAmount();
+    LeagueEntry *entries = malloc(sizeof(LeagueEntry) * count);
+    LeagueEntry *threaded = malloc(sizeof(LeagueEntry) * count);
+    LeagueEntry *single = malloc(sizeof(LeagueEntry) * count);
+    if (entries == NULL || threaded == NULL || single == NULL)
+    {
+        fprintf(stderr, "Memory allocation failed.\n");
+        free(entries);
+        free(threaded);
+        free(single);
+        return 0;
+    }
+    // at least two shares even on one CPU, so the threads and the merge always run
+    int threadCount = count / LEAGUE_OWNERS_PER_THREAD;
+    OwnerNode *owner = ownerHead;
+    for (int i = 0; i < count; i++, owner = owner->next)
+        entries[i].owner = owner;
+    uint64_t start = nowNanos();
+    rankLeague(entries, threaded, count, threadCount);
+    uint64_t threadedNanos = nowNanos() - start;
+
+    owner = ownerHead;
+    for (int i = 0; i < count; i++, owner = owner->next)
+        entries[i].owner = owner;
+    start = nowNanos();
+    rankLeague(entries, single, count, 1);
+    uint64_t singleNanos = nowNanos() - start;
+
+    int ok = 1;
+    for (int i = 0; i < count && ok; i++)
+    {
+        ok = threaded[i].owner == single[i].owner && threaded[i].strength == single[i].strength;
+        if (!ok)
+            fprintf(stderr, "league: place %d is %s on %d threads but %s on one\n", i + 1,
+                    threaded[i].owner->ownerName, threadCount, single[i].owner->ownerName);
+    }
+
+    fprintf(stderr, "\n%-8s %8s %8s %10s\n", "league", "owners", "threads", "ms");
+    fprintf(stderr, "%-8s %8d %8d %10.2f\n", "threaded", count, threadCount, threadedNanos / 1e6);
+    fprintf(stderr, "%-8s %8d %8d %10.2f\n", "single", count, 1, singleNanos / 1e6);
+    free(entries);
+    free(threaded);
+    free(single);
+    return ok;
+}
+
+static void usage(const char *program)
+{
+    fprintf(stderr, "Usage: %s [-o owners] [-n operations] [-s seed] [-d uniform|sequential|skewed]\n", program);
+}
+
+int main(int argc, char *argv[])
+{
+    int ownerCount = 1000;
+    long opCount = 200000;
+    uint64_t seed = 1;
+    IdDistribution distribution = IDS_UNIFORM;
+    const char *distributionName = "uniform";
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (i + 1 >= argc)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        const char *value = argv[++i];
+        if (strcmp(argv[i - 1], "-o") == 0)
+            ownerCount = atoi(value);
+        else if (strcmp(argv[i - 1], "-n") == 0)
+            opCount = atol(value);
+        else if (strcmp(argv[i - 1], "-s") == 0)
+            seed = strtoull(value, NULL, 10);
+        else if (strcmp(argv[i - 1], "-d") == 0)
+        {
+            distributionName = value;
+            if (strcmp(value, "uniform") == 0)
+                distribution = IDS_UNIFORM;
+            else if (strcmp(value, "sequential") == 0)
+                distribution = IDS_SEQUENTIAL;
+            else if (strcmp(value, "skewed") == 0)
+                distribution = IDS_SKEWED;
+            else
+            {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (ownerCount < 2 || opCount < 1)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+    // xorshift gets stuck at 0
+    rngState = seed ? seed : 1;
+
+    initNameRanks();
+    initSpeciesTable();
+    OwnerNode **owners = malloc(sizeof(OwnerNode *) * ownerCount);
+    int *sequences = calloc(ownerCount, sizeof(int));
+    uint64_t *samples[BENCH_OP_COUNT];
+    long sampleCount[BENCH_OP_COUNT] = {0};
+    uint64_t totalNanos[BENCH_OP_COUNT] = {0};
+    int failed = owners == NULL || sequences == NULL;
+    for (int op = 0; op < BENCH_OP_COUNT; op++)
+    {
+        samples[op] = malloc(sizeof(uint64_t) * opCount);
+        failed |= samples[op] == NULL;
+    }
+    int nextSerial = 0;
+    for (int i = 0; i < ownerCount && !failed; i++)
+    {
+        owners[i] = benchOwner(nextSerial++);
+        failed |= owners[i] == NULL;
+    }
+    if (failed)
+    {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return 1;
+    }
+
+    for (long n = 0; n < opCount; n++)
+    {
+        int pick = randomBelow(1000);
+        int op = 0;
+        while (pick >= benchMix[op].weight)
+            pick -= benchMix[op++].weight;
+        int slot = randomBelow(ownerCount);
+        OwnerNode *owner = owners[slot];
+        // draw the arguments before starting the clock
+        int id = nextId(distribution, &sequences[slot]);
+        int otherId = nextId(distribution, &sequences[slot]);
+        int otherSlot = (slot + 1 + randomBelow(ownerCount - 1)) % ownerCount;
+
+        uint64_t start = nowNanos();
+        switch (op)
+        {
+        case BENCH_ADD:
+            applyAddPokemon(owner, id);
+            break;
+        case BENCH_RELEASE:
+            applyReleasePokemon(owner, id);
+            break;
+        case BENCH_EVOLVE:
+            applyEvolvePokemon(owner, id);
+            break;
+        case BENCH_FIGHT:
+            fightPokemonByID(owner, id, otherId);
+            break;
+        case BENCH_DISPLAY:
+            displayPokedexOrder(owner, id % 5 + 1);
+            break;
+        case BENCH_MERGE:
+            applyMergeOwners(owner, owners[otherSlot]);
+            break;
+        case BENCH_SORT:
+            sortOwners();
+            break;
+        }
+        uint64_t elapsed = nowNanos() - start;
+        samples[op][sampleCount[op]++] = elapsed;
+        totalNanos[op] += elapsed;
+
+        // keep the owner count steady: the merged-away owner is replaced by a fresh one
+        if (op == BENCH_MERGE)
+        {
+            owners[otherSlot] = benchOwner(nextSerial++);
+            sequences[otherSlot] = 0;
+            if (owners[otherSlot] == NULL)
+            {
+                fprintf(stderr, "Memory allocation failed.\n");
+                return 1;
+            }
+        }
+    }
+    fflush(stdout);
+
+    fprintf(stderr, "owners=%d operations=%ld seed=%llu ids=%s\n",
+            ownerCount, opCount, (unsigned long long)seed, distributionName);
+    fprintf(stderr, "%-8s %10s %14s %10s %10s\n", "op", "count", "ops/sec", "p50 ns", "p99 ns");
+    uint64_t allNanos = 0;
+    for (int op = 0; op < BENCH_OP_COUNT; op++)
+    {
+        allNanos += totalNanos[op];
+        if (sampleCount[op] == 0)
+        {
+            fprintf(stderr, "%-8s %10d %14s %10s %10s\n", benchMix[op].name, 0, "-", "-", "-");
+            continue;
+        }
+        qsort(samples[op], sampleCount[op], sizeof(uint64_t), compareNanos);
+        double seconds = totalNanos[op] / 1e9;
+        fprintf(stderr, "%-8s %10ld %14.0f %10llu %10llu\n", benchMix[op].name, sampleCount[op],
+                seconds > 0 ? sampleCount[op] / seconds : 0.0,
+                (unsigned long long)samples[op][(sampleCount[op] - 1) / 2],
+                (unsigned long long)samples[op][(sampleCount[op] - 1) * 99 / 100]);
+    }
+    fprintf(stderr, "%-8s %10ld %14.0f\n", "all", opCount, allNanos > 0 ? opCount / (allNanos / 1e9) : 0.0);
+#ifdef POKEDEX_STATS
+    fprintf(stderr, "\n");
+    printOpStats(stderr);
+#endif
+    // after the stats table, so its tree lookups aren't charged to the last operation
+    int compactOk = benchCompact(owners, ownerCount, opCount);
+    // last, because it adds owners the rest of the bench never sees
+    int leagueOk = benchLeague(&nextSerial);
+
+    for (int op = 0; op < BENCH_OP_COUNT; op++)
+        free(samples[op]);
+    free(sequences);
+    free(owners);
+    freeAllOwners();
+    freePokemonQueue(&bfsQueue);
+    outFlush();
+    return compactOk && leagueOk ? 0 : 1;
+}
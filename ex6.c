@@ -1,50 +1,127 @@
+// read(2) for the stdin line reader
+#define _POSIX_C_SOURCE 200809L
+
 #include "ex6.h"
 #include <ctype.h>
+#include <errno.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-
-# define INT_BUFFER 128
+#include <time.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+# define INPUT_BUFFER_SIZE 65536
+# define QUEUE_START_CAPACITY 16
+# define SLAB_START_NODES 8
+# define SLAB_MAX_NODES 64
+// explicit traversal stacks hold at most one node per level; an AVL tree this tall
+// would need far more nodes than memory can hold
+# define MAX_TREE_HEIGHT 64
+# define INDEX_START_BUCKETS 16
+# define OUTPUT_BUFFER_SIZE 65536
+// longest batch command is "fight <owner> <id> <id>"
+# define BATCH_MAX_WORDS 4
+# define SNAPSHOT_MAGIC "PKDX"
+# define SNAPSHOT_VERSION 2
+# define JOURNAL_MAGIC "PKJL"
+# define JOURNAL_VERSION 1
+# define JOURNAL_BUFFER_SIZE 65536
+// group commit: records are written and fsynced once this many bytes are pending
+// or this long after the last commit, whichever comes first
+# define JOURNAL_COMMIT_BYTES 32768
+# define JOURNAL_COMMIT_NANOS 50000000L
+// a league team is an owner's best this many Pokemon
+# define LEAGUE_TEAM_SIZE 6
+# define LEAGUE_MAX_THREADS 16
+// fewer owners than this per thread and starting the thread costs more than it saves
+# define LEAGUE_OWNERS_PER_THREAD 4096
+// append a string literal without measuring it at runtime
+# define OUT_LITERAL(str) outString(str, sizeof(str) - 1)
+
+// instrumentation counters, built with -DPOKEDEX_STATS; otherwise every STAT_ macro is empty
+#ifdef POKEDEX_STATS
+# define STAT_BEGIN(op) (currentStatOp = (op), opStats[op].calls++)
+# define STAT_COUNT(field, n) (opStats[currentStatOp].field += (n))
+# define STAT_MAX(field, value) \
+    do { if ((value) > opStats[currentStatOp].field) opStats[currentStatOp].field = (value); } while (0)
+static OpStats opStats[STAT_OP_COUNT];
+static StatOp currentStatOp = STAT_OP_OTHER;
+static const char *statOpNames[STAT_OP_COUNT] = {
+    "other", "new", "add", "release", "evolve", "fight", "display", "delete", "merge", "sort", "print",
+    "evolveall", "addmany", "releasewhere"};
+#else
+# define STAT_BEGIN(op) ((void)0)
+# define STAT_COUNT(field, n) ((void)0)
+# define STAT_MAX(field, value) ((void)0)
+#endif
+
+// set by --snapshot: loaded at startup, where the save command writes by default
+static const char *snapshotPath = NULL;
+// generation of the snapshot that was loaded or last saved to snapshotPath
+static uint32_t snapshotGeneration = 0;
+
+// operation journal next to the snapshot; records wait in journalBuffer until journalCommit
+static int journalFd = -1;
+static char *journalPath = NULL;
+static char journalBuffer[JOURNAL_BUFFER_SIZE];
+static size_t journalUsed = 0;
+static long journalLastCommit = 0;
+static int journalReplaying = 0;
+
+// shared by BFSGeneric and searchPokemonBFS, freed at exit
+static PokemonQueue bfsQueue = {NULL, 0, 0, 0};
+
+// alphabetical position of each species name, by ID (species names never change)
+static int nameRank[MAX_POKEMON_ID + 1];
+
+// pokedex[] by column, filled by initSpeciesTable()
+static SpeciesTable speciesTable;
+
+// display output is collected here and written to stdout in large blocks by outFlush()
+static char outputBuffer[OUTPUT_BUFFER_SIZE];
+static size_t outputUsed = 0;
+
+// stdin is read into here in big chunks; [inputStart, inputEnd) is not handed out yet.
+// One spare byte so the last line can always be NUL-terminated in place.
+static char inputBuffer[INPUT_BUFFER_SIZE + 1];
+static size_t inputStart = 0;
+static size_t inputEnd = 0;
+
+// type names by enum value, with their lengths worked out at compile time
+#define TYPE_NAME(str) {str, sizeof(str) - 1}
+static const struct
+{
+    const char *name;
+    size_t length;
+} typeNames[] = {
+    TYPE_NAME("GRASS"), TYPE_NAME("FIRE"), TYPE_NAME("WATER"), TYPE_NAME("BUG"),
+    TYPE_NAME("NORMAL"), TYPE_NAME("POISON"), TYPE_NAME("ELECTRIC"), TYPE_NAME("GROUND"),
+    TYPE_NAME("FAIRY"), TYPE_NAME("FIGHTING"), TYPE_NAME("PSYCHIC"), TYPE_NAME("ROCK"),
+    TYPE_NAME("GHOST"), TYPE_NAME("DRAGON"), TYPE_NAME("ICE")};
+#define TYPE_COUNT ((int)(sizeof(typeNames) / sizeof(typeNames[0])))
 
 // ================================================
 // Basic struct definitions from ex6.h assumed:
 //   PokemonData { int id; char *name; PokemonType TYPE; int hp; int attack; EvolutionStatus CAN_EVOLVE; }
-//   PokemonNode { PokemonData* data; PokemonNode* left, *right; }
-//   OwnerNode   { char* ownerName; PokemonNode* pokedexRoot; OwnerNode *next, *prev; }
+//   PokemonNode { PokemonData* data; PokemonNode* left, *right; int height; }
+//   OwnerNode   { char* ownerName; PokemonNode* pokedexRoot; OwnerNode *next, *prev; arena; hashNext; uint32_t ownedIds[]; }
 //   OwnerNode* ownerHead;
 //   const PokemonData pokedex[];
 // ================================================
 
-// For alphabetical display, we collect all nodes in an array, then qsort by name
+// For alphabetical display, species are ranked by name once at startup, then nodes are bucketed by rank
 
 
 // --------------------------------------------------------------
 // 1) Safe integer reading
 // --------------------------------------------------------------
 
-void trimWhitespace(char *str)
-{
-    // Remove leading spaces/tabs/\r
-    int start = 0;
-    while (str[start] == ' ' || str[start] == '\t' || str[start] == '\r')
-        start++;
-
-    if (start > 0)
-    {
-        int idx = 0;
-        while (str[start])
-            str[idx++] = str[start++];
-        str[idx] = '\0';
-    }
-
-    // Remove trailing spaces/tabs/\r
-    int len = (int)strlen(str);
-    while (len > 0 && (str[len - 1] == ' ' || str[len - 1] == '\t' || str[len - 1] == '\r'))
-    {
-        str[--len] = '\0';
-    }
-}
-
 char *myStrdup(const char *src)
 {
     if (!src)
@@ -56,60 +133,142 @@ char *myStrdup(const char *src)
         printf("Memory allocation failed in myStrdup.\n");
         return NULL;
     }
+    STAT_COUNT(mallocs, 1);
     strcpy(dest, src);
     return dest;
 }
 
-int readIntSafe(const char *prompt)
+char *readLine(size_t *length)
 {
-    char buffer[INT_BUFFER];
-    int value;
-    int success = 0;
-
-    while (!success)
+    size_t scanned = inputStart;
+    char *newline = NULL;
+    while (1)
     {
-        printf("%s", prompt);
-
-        // If we fail to read, treat it as invalid
-        if (!fgets(buffer, sizeof(buffer), stdin))
+        newline = (char *)memchr(inputBuffer + scanned, '\n', inputEnd - scanned);
+        if (newline)
+            break;
+        // no full line buffered: slide the partial one to the front and read more
+        if (inputStart > 0)
         {
-            printf("Invalid input.\n");
-            clearerr(stdin);
+            memmove(inputBuffer, inputBuffer + inputStart, inputEnd - inputStart);
+            inputEnd -= inputStart;
+            inputStart = 0;
+        }
+        scanned = inputEnd;
+        if (inputEnd == INPUT_BUFFER_SIZE)
+            break;
+        // anything the user should see before we block has to be out first,
+        // and this is an idle moment to commit the journal
+        outFlush();
+        fflush(stdout);
+        journalCommit();
+        ssize_t got = read(STDIN_FILENO, inputBuffer + inputEnd, INPUT_BUFFER_SIZE - inputEnd);
+        if (got < 0 && errno == EINTR)
             continue;
+        if (got <= 0)
+        {
+            if (inputEnd == inputStart)
+                return NULL;
+            // last line without a newline
+            break;
         }
+        inputEnd += (size_t)got;
+    }
 
-        // 1) Strip any trailing \r or \n
-        //    so "123\r\n" becomes "123"
-        size_t len = strlen(buffer);
-        if (len > 0 && (buffer[len - 1] == '\n' || buffer[len - 1] == '\r'))
-            buffer[--len] = '\0';
-        if (len > 0 && (buffer[len - 1] == '\r' || buffer[len - 1] == '\n'))
-            buffer[--len] = '\0';
+    char *start = inputBuffer + inputStart;
+    char *end = newline ? newline : inputBuffer + inputEnd;
+    inputStart = (size_t)(end - inputBuffer) + (newline ? 1 : 0);
 
-        // 2) Check if empty after stripping
-        if (len == 0)
-        {
-            printf("Invalid input.\n");
-            continue;
-        }
+    // trim spaces, tabs and \r from both ends
+    while (start < end && (*start == ' ' || *start == '\t' || *start == '\r'))
+        start++;
+    while (end > start && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r'))
+        end--;
+    *end = '\0';
+    *length = (size_t)(end - start);
+    return start;
+}
+
+int parseIntSlice(const char *str, size_t length, int *value)
+{
+    size_t i = 0;
+    int negative = 0;
+    if (i < length && (str[i] == '-' || str[i] == '+'))
+        negative = (str[i++] == '-');
+    if (i == length)
+        return 0;
 
-        // 3) Attempt to parse integer with strtol
-        char *endptr;
-        value = (int)strtol(buffer, &endptr, 10);
+    // accumulate as a negative number so INT_MIN still fits
+    int result = 0;
+    for (; i < length; i++)
+    {
+        if (str[i] < '0' || str[i] > '9')
+            return 0;
+        int digit = str[i] - '0';
+        if (result < (INT_MIN + digit) / 10)
+            return 0;
+        result = result * 10 - digit;
+    }
+    if (!negative)
+    {
+        if (result == INT_MIN)
+            return 0;
+        result = -result;
+    }
+    *value = result;
+    return 1;
+}
 
-        // If endptr didn't point to the end => leftover chars => invalid
-        // or if buffer was something non-numeric
-        if (*endptr != '\0')
-        {
-            printf("Invalid input.\n");
-        }
-        else
+int parseIdRanges(const char *text, uint32_t *ids)
+{
+    memset(ids, 0, OWNED_WORDS * sizeof(uint32_t));
+    const char *item = text;
+    while (1)
+    {
+        const char *end = strchr(item, ',');
+        if (end == NULL)
+            end = item + strlen(item);
+        while (item < end && isspace((unsigned char)*item))
+            item++;
+        const char *last = end;
+        while (last > item && isspace((unsigned char)last[-1]))
+            last--;
+        // a range's dash comes after its first digit, so "-5" stays a (bad) single number
+        const char *dash = item < last ? memchr(item + 1, '-', last - item - 1) : NULL;
+        int low, high;
+        if (dash == NULL)
         {
-            // We got a valid integer
-            success = 1;
+            if (!parseIntSlice(item, last - item, &low))
+                return 0;
+            high = low;
         }
+        else if (!parseIntSlice(item, dash - item, &low) || !parseIntSlice(dash + 1, last - dash - 1, &high))
+            return 0;
+        if (low < 1 || high > MAX_POKEMON_ID || low > high)
+            return 0;
+        for (int id = low; id <= high; id++)
+            ids[id / 32] |= 1u << (id % 32);
+        if (*end == '\0')
+            return 1;
+        item = end + 1;
+    }
+}
+
+int readIntSafe(const char *prompt)
+{
+    int value;
+    while (1)
+    {
+        outFlush();
+        printf("%s", prompt);
+
+        size_t length;
+        char *line = readLine(&length);
+        // empty, non-numeric or out of range (or nothing left to read) => ask again
+        if (line && parseIntSlice(line, length, &value))
+            return value;
+        printf("Invalid input.\n");
     }
-    return value;
 }
 
 // --------------------------------------------------------------
@@ -117,79 +276,133 @@ int readIntSafe(const char *prompt)
 // --------------------------------------------------------------
 const char *getTypeName(PokemonType type)
 {
-    switch (type)
-    {
-    case GRASS:
-        return "GRASS";
-    case FIRE:
-        return "FIRE";
-    case WATER:
-        return "WATER";
-    case BUG:
-        return "BUG";
-    case NORMAL:
-        return "NORMAL";
-    case POISON:
-        return "POISON";
-    case ELECTRIC:
-        return "ELECTRIC";
-    case GROUND:
-        return "GROUND";
-    case FAIRY:
-        return "FAIRY";
-    case FIGHTING:
-        return "FIGHTING";
-    case PSYCHIC:
-        return "PSYCHIC";
-    case ROCK:
-        return "ROCK";
-    case GHOST:
-        return "GHOST";
-    case DRAGON:
-        return "DRAGON";
-    case ICE:
-        return "ICE";
-    default:
+    if ((int)type < 0 || (int)type >= TYPE_COUNT)
         return "UNKNOWN";
+    return typeNames[type].name;
+}
+
+int parseTypeName(const char *name)
+{
+    size_t length = strlen(name);
+    for (int type = 0; type < TYPE_COUNT; type++)
+    {
+        if (typeNames[type].length != length)
+            continue;
+        size_t i = 0;
+        while (i < length && toupper((unsigned char)name[i]) == typeNames[type].name[i])
+            i++;
+        if (i == length)
+            return type;
     }
+    return -1;
 }
 
-// --------------------------------------------------------------
-// Utility: getDynamicInput (for reading a line into malloc'd memory)
-// --------------------------------------------------------------
-char *getDynamicInput()
+int parseReleasePredicate(const char *text, ReleasePredicate *predicate)
 {
-    char *input = NULL;
-    size_t size = 0, capacity = 1;
-    input = (char *)malloc(capacity);
-    if (!input)
+    predicate->low = 0;
+    predicate->high = 0;
+    if (strncmp(text, "type=", 5) == 0)
     {
-        printf("Memory allocation failed.\n");
-        return NULL;
+        predicate->rule = RELEASE_TYPE;
+        predicate->low = parseTypeName(text + 5);
+        return predicate->low >= 0;
+    }
+    if (strncmp(text, "hp<", 3) == 0)
+    {
+        predicate->rule = RELEASE_HP_BELOW;
+        return parseIntSlice(text + 3, strlen(text + 3), &predicate->low);
+    }
+    if (strncmp(text, "attack=", 7) == 0)
+    {
+        predicate->rule = RELEASE_ATTACK_RANGE;
+        const char *range = text + 7;
+        const char *dash = *range != '\0' ? strchr(range + 1, '-') : NULL;
+        if (dash == NULL)
+            return 0;
+        return parseIntSlice(range, dash - range, &predicate->low) &&
+               parseIntSlice(dash + 1, strlen(dash + 1), &predicate->high) && predicate->low <= predicate->high;
+    }
+    if (strcmp(text, "evolve=yes") == 0)
+    {
+        predicate->rule = RELEASE_CAN_EVOLVE;
+        return 1;
+    }
+    if (strcmp(text, "evolve=no") == 0)
+    {
+        predicate->rule = RELEASE_CANNOT_EVOLVE;
+        return 1;
     }
+    return 0;
+}
+
+// --------------------------------------------------------------
+// Utility: buffered output for the display paths
+// --------------------------------------------------------------
+void outFlush()
+{
+    if (outputUsed == 0)
+        return;
+    fwrite(outputBuffer, 1, outputUsed, stdout);
+    outputUsed = 0;
+}
 
-    int c;
-    while ((c = getchar()) != '\n' && c != EOF)
+void outString(const char *str, size_t len)
+{
+    if (outputUsed + len > OUTPUT_BUFFER_SIZE)
     {
-        if (size + 1 >= capacity)
+        outFlush();
+        // too big to ever fit, send it straight through
+        if (len > OUTPUT_BUFFER_SIZE)
         {
-            capacity *= 2;
-            char *temp = (char *)realloc(input, capacity);
-            if (!temp)
-            {
-                printf("Memory reallocation failed.\n");
-                free(input);
-                return NULL;
-            }
-            input = temp;
+            fwrite(str, 1, len, stdout);
+            return;
         }
-        input[size++] = (char)c;
     }
-    input[size] = '\0';
+    memcpy(outputBuffer + outputUsed, str, len);
+    outputUsed += len;
+}
+
+void outChar(char c)
+{
+    if (outputUsed == OUTPUT_BUFFER_SIZE)
+        outFlush();
+    outputBuffer[outputUsed++] = c;
+}
 
-    // Trim any leading/trailing whitespace or carriage returns
-    trimWhitespace(input);
+void outInt(int value)
+{
+    char digits[12];
+    int pos = sizeof(digits);
+    // work in unsigned so INT_MIN doesn't overflow when negated
+    unsigned int magnitude = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+    do
+    {
+        digits[--pos] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0)
+        digits[--pos] = '-';
+    outString(digits + pos, sizeof(digits) - pos);
+}
 
+// --------------------------------------------------------------
+// Utility: getDynamicInput (for reading a line into malloc'd memory)
+// --------------------------------------------------------------
+char *getDynamicInput()
+{
+    size_t length = 0;
+    char *line = readLine(&length);
+    char *input = (char *)malloc(length + 1);
+    STAT_COUNT(mallocs, 1);
+    if (!input)
+    {
+        printf("Memory allocation failed.\n");
+        return NULL;
+    }
+    // at end of input this is just an empty name
+    if (line)
+        memcpy(input, line, length);
+    input[length] = '\0';
     return input;
 }
 
@@ -198,13 +411,25 @@ void printPokemonNode(PokemonNode *node)
 {
     if (!node)
         return;
-    printf("ID: %d, Name: %s, Type: %s, HP: %d, Attack: %d, Can Evolve: %s\n",
-           node->data->id,
-           node->data->name,
-           getTypeName(node->data->TYPE),
-           node->data->hp,
-           node->data->attack,
-           (node->data->CAN_EVOLVE == CAN_EVOLVE) ? "Yes" : "No");
+    // same line as "ID: %d, Name: %s, Type: %s, HP: %d, Attack: %d, Can Evolve: %s\n"
+    const PokemonData *data = node->data;
+    OUT_LITERAL("ID: ");
+    outInt(data->id);
+    OUT_LITERAL(", Name: ");
+    outString(data->name, strlen(data->name));
+    OUT_LITERAL(", Type: ");
+    if ((int)data->TYPE >= 0 && (int)data->TYPE < TYPE_COUNT)
+        outString(typeNames[data->TYPE].name, typeNames[data->TYPE].length);
+    else
+        OUT_LITERAL("UNKNOWN");
+    OUT_LITERAL(", HP: ");
+    outInt(data->hp);
+    OUT_LITERAL(", Attack: ");
+    outInt(data->attack);
+    if (data->CAN_EVOLVE == CAN_EVOLVE)
+        OUT_LITERAL(", Can Evolve: Yes\n");
+    else
+        OUT_LITERAL(", Can Evolve: No\n");
 }
 
 // --------------------------------------------------------------
@@ -225,9 +450,13 @@ void displayMenu(OwnerNode *owner)
     printf("4. Post-Order\n");
     printf("5. Alphabetical (by name)\n");
 
-    int choice = readIntSafe("Your choice: ");
+    displayPokedexOrder(owner, readIntSafe("Your choice: "));
+}
 
-    switch (choice)
+void displayPokedexOrder(OwnerNode *owner, int order)
+{
+    STAT_BEGIN(STAT_OP_DISPLAY);
+    switch (order)
     {
     case 1:
         BFSGeneric(owner->pokedexRoot, printPokemonNode);
@@ -247,6 +476,7 @@ void displayMenu(OwnerNode *owner)
     default:
         printf("Invalid choice.\n");
     }
+    outFlush();
 }
 
 // --------------------------------------------------------------
@@ -259,20 +489,10 @@ void enterExistingPokedexMenu()
         printf("No existing Pokedexes.\n");
         return;
     }
-    int index = 1;
     OwnerNode* current = ownerHead;
     // list owners
     printf("\nExisting Pokedexes:\n");
-    if (current == NULL)
-        return;
-    printf("%d. %s\n", index, current->ownerName);
-    current = current->next;
-    while (current != ownerHead)
-    {
-        index++;
-        printf("%d. %s\n", index, current->ownerName);
-        current = current->next;
-    }
+    printOwnerList();
 
     int owner = readIntSafe("Choose a Pokedex by number: ");
     current = ownerHead;
@@ -290,6 +510,10 @@ void enterExistingPokedexMenu()
         printf("4. Pokemon Fight!\n");
         printf("5. Evolve Pokemon\n");
         printf("6. Back to Main\n");
+        printf("7. Tournament\n");
+        printf("8. Evolve All\n");
+        printf("9. Add Many\n");
+        printf("10. Release Many\n");
 
         subChoice = readIntSafe("Your choice: ");
 
@@ -313,6 +537,18 @@ void enterExistingPokedexMenu()
         case 6:
             printf("Back to Main Menu.\n");
             break;
+        case 7:
+            pokemonTournament(current);
+            break;
+        case 8:
+            evolveAllMenu(current);
+            break;
+        case 9:
+            addManyMenu(current);
+            break;
+        case 10:
+            releaseWhereMenu(current);
+            break;
         default:
             printf("Invalid choice.\n");
         }
@@ -335,6 +571,11 @@ void mainMenu()
         printf("5. Sort Owners by Name\n");
         printf("6. Print Owners in a direction X times\n");
         printf("7. Exit\n");
+        printf("8. Save Snapshot\n");
+        printf("9. League Standings\n");
+#ifdef POKEDEX_STATS
+        printf("10. Operation Stats\n");
+#endif
         choice = readIntSafe("Your choice: ");
 
         switch (choice)
@@ -360,18 +601,72 @@ void mainMenu()
         case 7:
             printf("Goodbye!\n");
             break;
+        case 8:
+            saveSnapshotMenu();
+            break;
+        case 9:
+            runLeague();
+            break;
+#ifdef POKEDEX_STATS
+        case 10:
+            printOpStats(stdout);
+            break;
+#endif
         default:
             printf("Invalid.\n");
         }
     } while (choice != 7);
 }
 
-int main()
+// bench.c includes this file with EX6_NO_MAIN and brings its own main
+#ifndef EX6_NO_MAIN
+int main(int argc, char *argv[])
 {
-    mainMenu();
+    int batch = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--batch") == 0)
+            batch = 1;
+        else if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc)
+            snapshotPath = argv[++i];
+        else
+        {
+            fprintf(stderr, "Usage: %s [--batch] [--snapshot FILE]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    initNameRanks();
+    initSpeciesTable();
+    if (snapshotPath != NULL && loadSnapshot(snapshotPath) < 0)
+    {
+        fprintf(stderr, "Could not load snapshot '%s'.\n", snapshotPath);
+        freeAllOwners();
+        return 1;
+    }
+    if (snapshotPath != NULL && openJournal(snapshotPath) < 0)
+    {
+        fprintf(stderr, "Could not replay the journal of '%s'.\n", snapshotPath);
+        closeJournal();
+        freeAllOwners();
+        return 1;
+    }
+    if (batch)
+        runBatch();
+    else
+        mainMenu();
+#ifdef POKEDEX_STATS
+    outFlush();
+    fflush(stdout);
+    printOpStats(stderr);
+#endif
+    closeJournal();
     freeAllOwners();
+    freePokemonQueue(&bfsQueue);
+    outFlush();
     return 0;
 }
+#endif
 
 void openPokedexMenu()
 {
@@ -390,72 +685,169 @@ void openPokedexMenu()
                 "2. Charmander\n"
                 "3. Squirtle\n");
     starter = readIntSafe("Your choice: ");
-    PokemonNode* pokemon = createPokemonNode(&pokedex[(starter - 1) * 3]);
-    OwnerNode* newOwner = createOwner(name, pokemon);
-    linkOwnerInCircularList(newOwner);
-    printf("New Pokedex created for %s with starter %s.", newOwner->ownerName, newOwner->pokedexRoot->data->name);
-
+    if (starter < 1 || starter > 3)
+    {
+        printf("Invalid choice.\n");
+        free(name);
+        return;
+    }
+    // the owner keeps the buffer as its name, so it is never freed here
+    if (adoptNewOwner(name, starter) == OP_OK)
+        printf("New Pokedex created for %s with starter %s.", name, pokedex[(starter - 1) * 3].name);
 }
 
-PokemonNode *createPokemonNode(const PokemonData *data)
+PokemonNode *createPokemonNode(PokemonArena *arena, const PokemonData *data)
 {
-    PokemonNode *pokeNode = (PokemonNode *)malloc(sizeof(PokemonNode));
+    PokemonNode *pokeNode = allocPokemonNode(arena);
     if (pokeNode == NULL)
     {
         printf("Memory allocation failed.\n");
-        free(pokeNode);
         return NULL;
     }
     pokeNode->data = data;
     pokeNode->left = NULL;
     pokeNode->right = NULL;
+    pokeNode->height = 1;
     return pokeNode;
 }
 
 /**
  * @brief Create an OwnerNode for the circular owners list.
  * @param ownerName the dynamically allocated name
- * @param starter BST root for the starter Pokemon
+ * @param starter the starter Pokemon, becomes the BST root
  * @return newly allocated OwnerNode*
  * Why we made it: Each user is represented as an OwnerNode.
  */
-OwnerNode *createOwner(char *ownerName, PokemonNode *starter)
+OwnerNode *createOwner(char *ownerName, const PokemonData *starter)
 {
     OwnerNode *ownerNode = (OwnerNode *)malloc(sizeof(OwnerNode));
-    if (ownerName == NULL)
+    if (ownerNode == NULL)
     {
         printf("Memory allocation failed.\n");
         return NULL;
     }
+    STAT_COUNT(mallocs, 1);
     ownerNode->ownerName = ownerName;
-    ownerNode->pokedexRoot = starter;
     ownerNode->next = NULL;
     ownerNode->prev = NULL;
+    ownerNode->hashNext = NULL;
+    initPokemonArena(&ownerNode->arena);
+    memset(ownerNode->ownedIds, 0, sizeof(ownerNode->ownedIds));
+    ownerNode->pokedexRoot = NULL;
+    if (starter != NULL)
+    {
+        ownerNode->pokedexRoot = createPokemonNode(&ownerNode->arena, starter);
+        // the bitmap must agree with the tree, so no bit for a starter that couldn't be allocated
+        if (ownerNode->pokedexRoot != NULL)
+            markPokemonOwned(ownerNode, starter->id);
+    }
     return ownerNode;
 }
 
 /**
  * @brief Free one PokemonNode (including name).
+ * @param arena the arena the node was allocated from
  * @param node pointer to node
  * Why we made it: Avoid memory leaks for single nodes.
  */
-void freePokemonNode(PokemonNode *node)
+void freePokemonNode(PokemonArena *arena, PokemonNode *node)
 {
-    free(node);
+    if (node == NULL)
+        return;
+    STAT_COUNT(nodeFrees, 1);
+    node->left = arena->freeList;
+    arena->freeList = node;
 }
 
 /**
- * @brief Recursively free a BST of PokemonNodes.
+ * @brief Free a BST of PokemonNodes (iterative, explicit stack).
+ * @param arena the arena the nodes were allocated from
  * @param root BST root
- * Why we made it: Clearing a user’s entire Pokedex means freeing a tree.
+ * Why we made it: Clearing part of a Pokedex means freeing a subtree (a whole Pokedex just drops its arena).
  */
-void freePokemonTree(PokemonNode *root)
+void freePokemonTree(PokemonArena *arena, PokemonNode *root)
 {
+    PokemonNode *stack[MAX_TREE_HEIGHT + 1];
+    int top = 0;
     if (root == NULL)
         return;
-    freePokemonTree(root->left);
-    freePokemonTree(root->right);
-    freePokemonNode(root);
+    stack[top++] = root;
+    while (top > 0)
+    {
+        PokemonNode *current = stack[--top];
+        // take the children before freeing, the free list reuses the left pointer
+        if (current->right != NULL)
+            stack[top++] = current->right;
+        if (current->left != NULL)
+            stack[top++] = current->left;
+        STAT_MAX(maxDepth, top);
+        freePokemonNode(arena, current);
+    }
+}
+
+/**starts an empty arena, no slab is allocated until the first node*/
+void initPokemonArena(PokemonArena *arena)
+{
+    arena->slabs = NULL;
+    arena->freeList = NULL;
+}
+
+/**gives back an unused node slot: a released node first, otherwise the next slot of the newest slab (a new slab when it's full)*/
+PokemonNode *allocPokemonNode(PokemonArena *arena)
+{
+    STAT_COUNT(nodeAllocs, 1);
+    if (arena->freeList != NULL)
+    {
+        PokemonNode *node = arena->freeList;
+        arena->freeList = node->left;
+        return node;
+    }
+    PokemonSlab *slab = arena->slabs;
+    if (slab == NULL || slab->used == slab->capacity)
+    {
+        // slabs double in size so a full Pokedex needs only a handful of them
+        int capacity = slab == NULL ? SLAB_START_NODES : slab->capacity * 2;
+        if (capacity > SLAB_MAX_NODES)
+            capacity = SLAB_MAX_NODES;
+        PokemonSlab *newSlab = (PokemonSlab *)malloc(sizeof(PokemonSlab) + capacity * sizeof(PokemonNode));
+        if (newSlab == NULL)
+            return NULL;
+        STAT_COUNT(mallocs, 1);
+        newSlab->next = slab;
+        newSlab->used = 0;
+        newSlab->capacity = capacity;
+        arena->slabs = newSlab;
+        slab = newSlab;
+    }
+    return &slab->nodes[slab->used++];
+}
+
+/**frees every slab of the arena at once, which frees all the nodes allocated from it*/
+void destroyPokemonArena(PokemonArena *arena)
+{
+    PokemonSlab *slab = arena->slabs;
+    while (slab != NULL)
+    {
+        PokemonSlab *next = slab->next;
+        free(slab);
+        slab = next;
+    }
+    initPokemonArena(arena);
+}
+
+/**moves all the slabs and released nodes of src into dst (src is left empty), so dst's tree can keep src's nodes*/
+void mergePokemonArenas(PokemonArena *dst, PokemonArena *src)
+{
+    // src's slabs go after dst's so dst keeps filling its own newest slab first
+    PokemonSlab **slabTail = &dst->slabs;
+    while (*slabTail != NULL)
+        slabTail = &(*slabTail)->next;
+    *slabTail = src->slabs;
+    PokemonNode **freeTail = &dst->freeList;
+    while (*freeTail != NULL)
+        freeTail = &(*freeTail)->left;
+    *freeTail = src->freeList;
+    initPokemonArena(src);
 }
 
 /**
@@ -466,51 +858,44 @@ void freePokemonTree(PokemonNode *root)
 void freeOwnerNode(OwnerNode *owner)
 {
     free(owner->ownerName);
-    freePokemonTree(owner->pokedexRoot);
+    // every node of the Pokedex came from the owner's arena, no need to walk the tree
+    destroyPokemonArena(&owner->arena);
+    owner->pokedexRoot = NULL;
     free(owner);
     //owner = NULL;
 }
 
 /**
  * @brief Insert a PokemonNode into BST by ID; duplicates freed.
+ * @param arena the owner's arena newNode was allocated from
  * @param root pointer to BST root
- * @param newNode node to insert
+ * @param newNode node to insert, linked into the tree as is (no copy is made)
  * @return updated BST root
  * Why we made it: Standard BST insertion ignoring duplicates.
  */
-PokemonNode *insertPokemonNode(PokemonNode *root, PokemonNode *newNode)
+PokemonNode *insertPokemonNode(PokemonArena *arena, PokemonNode *root, PokemonNode *newNode)
 {
     if (newNode == NULL)
         return root;
     if (root == NULL)
     {
-        PokemonNode* pokemon = createPokemonNode(newNode->data);
-        root = pokemon;
-        return root;
+        newNode->left = NULL;
+        newNode->right = NULL;
+        newNode->height = 1;
+        return newNode;
     }
+    STAT_COUNT(nodeVisits, 1);
+    STAT_COUNT(comparisons, 1);
     if(root->data->id > newNode->data->id)
+        root->left = insertPokemonNode(arena, root->left, newNode);
+    else if(root->data->id < newNode->data->id)
+        root->right = insertPokemonNode(arena, root->right, newNode);
+    else
     {
-        if (root->left == NULL)
-        {
-            PokemonNode* pokemon = createPokemonNode(newNode->data);
-            root->left = pokemon;
-            return root;
-        }
-        root->left = insertPokemonNode(root->left, newNode);
-        return root;
-    }
-    if(root->data->id < newNode->data->id)
-    {
-        if (root->right == NULL)
-        {
-            PokemonNode* pokemon = createPokemonNode(newNode->data);
-            root->right = pokemon;
-            return root;
-        }
-        root->right = insertPokemonNode(root->right, newNode);
+        freePokemonNode(arena, newNode);
         return root;
     }
-    return root;
+    return rebalance(root);
 }
 
 /**
@@ -524,69 +909,175 @@ PokemonNode *searchPokemonBFS(PokemonNode *root, int id)
 {
     if (root == NULL)
         return NULL;
-    int Height = pokedexHeight(root);
-    for(int i = 1 ; i <= Height ; i++)
+    bfsQueue.head = 0;
+    bfsQueue.tail = 0;
+    enqueuePokemon(&bfsQueue, root);
+    PokemonNode *current;
+    while((current = dequeuePokemon(&bfsQueue)) != NULL)
     {
-        PokemonNode *temp = searchPokemonByLevel(id, root, i);
-        if(temp != NULL)
-            return temp;
+        STAT_COUNT(nodeVisits, 1);
+        STAT_COUNT(comparisons, 1);
+        if(current->data->id == id)
+            return current;
+        if(current->left != NULL)
+            enqueuePokemon(&bfsQueue, current->left);
+        if(current->right != NULL)
+            enqueuePokemon(&bfsQueue, current->right);
     }
     return NULL;
 }
-/**goes over the bst by level by searching for a specific level (distance from the root) to check the pokemon*/
-PokemonNode *searchPokemonByLevel(int id, PokemonNode *root, int level)
+
+/**
+ * @brief Keyed search for a Pokemon by ID, descending by the BST ordering.
+ * @param root BST root
+ * @param id ID to find
+ * @return pointer to found node or NULL
+ * Why we made it: The tree is ordered by ID, so one root-to-leaf walk (O(log n)) is enough.
+ */
+PokemonNode *searchPokemonBST(PokemonNode *root, int id)
 {
-    if(root == NULL)
-        return NULL;
-    if(level == 1)
+    PokemonNode *current = root;
+    while(current != NULL && current->data->id != id)
     {
-        if(root->data->id == id)
-            return root;
-        return NULL;
+        STAT_COUNT(nodeVisits, 1);
+        STAT_COUNT(comparisons, 2);
+        current = current->data->id > id ? current->left : current->right;
     }
-    PokemonNode *left = searchPokemonByLevel(id, root->left, level - 1);
-    PokemonNode *right = searchPokemonByLevel(id, root->right, level - 1);
-    if(left != NULL)
-        return left;
-    if(right != NULL)
-        return right;
-    return NULL;
+    return current;
+}
+
+/**returns 1 if the owner has a Pokemon with this ID (a bit test, no tree walk), 0 otherwise*/
+int ownsPokemon(const OwnerNode *owner, int id)
+{
+    if(id <= 0 || id > MAX_POKEMON_ID)
+        return 0;
+    return (owner->ownedIds[id / 32] >> (id % 32)) & 1u;
+}
+
+/**sets the owner's bit for this ID, call after inserting it into the owner's tree*/
+void markPokemonOwned(OwnerNode *owner, int id)
+{
+    if(id <= 0 || id > MAX_POKEMON_ID)
+        return;
+    owner->ownedIds[id / 32] |= 1u << (id % 32);
 }
+
+/**clears the owner's bit for this ID, call after removing it from the owner's tree*/
+void unmarkPokemonOwned(OwnerNode *owner, int id)
+{
+    if(id <= 0 || id > MAX_POKEMON_ID)
+        return;
+    owner->ownedIds[id / 32] &= ~(1u << (id % 32));
+}
+
+int ownedIdList(const OwnerNode *owner, uint8_t *out)
+{
+    int count = 0;
+    for(int word = 0; word < OWNED_WORDS; word++)
+    {
+        uint32_t bits = owner->ownedIds[word];
+        for(int bit = 0; bits != 0; bit++, bits >>= 1)
+        {
+            if(bits & 1u)
+                out[count++] = (uint8_t)(word * 32 + bit);
+        }
+    }
+    return count;
+}
+
 /**returns the maximum height of the tree (the farther distance from a leaf to the root)*/
 int pokedexHeight(PokemonNode *root)
 {
     if (root == NULL)
         return 0;
-    int left = pokedexHeight(root->left);
-    int right = pokedexHeight(root->right);
-    return (left > right ? left : right) + 1;
+    return root->height;
+}
+
+/**recalculates the stored height of a node from the heights of its two children*/
+void updateHeight(PokemonNode *node)
+{
+    int left = pokedexHeight(node->left);
+    int right = pokedexHeight(node->right);
+    node->height = (left > right ? left : right) + 1;
+}
+
+/**rotates the subtree to the right around root and returns the new subtree root*/
+PokemonNode *rotateRight(PokemonNode *root)
+{
+    PokemonNode *newRoot = root->left;
+    root->left = newRoot->right;
+    newRoot->right = root;
+    updateHeight(root);
+    updateHeight(newRoot);
+    return newRoot;
+}
+
+/**rotates the subtree to the left around root and returns the new subtree root*/
+PokemonNode *rotateLeft(PokemonNode *root)
+{
+    PokemonNode *newRoot = root->right;
+    root->right = newRoot->left;
+    newRoot->left = root;
+    updateHeight(root);
+    updateHeight(newRoot);
+    return newRoot;
+}
+
+/**restores the AVL balance of a subtree after an insert or remove below it, returns the new subtree root*/
+PokemonNode *rebalance(PokemonNode *root)
+{
+    if(root == NULL)
+        return NULL;
+    updateHeight(root);
+    int balance = pokedexHeight(root->left) - pokedexHeight(root->right);
+    if(balance > 1)
+    {
+        // left-right case: straighten the left child first
+        if(pokedexHeight(root->left->left) < pokedexHeight(root->left->right))
+            root->left = rotateLeft(root->left);
+        return rotateRight(root);
+    }
+    if(balance < -1)
+    {
+        // right-left case: straighten the right child first
+        if(pokedexHeight(root->right->right) < pokedexHeight(root->right->left))
+            root->right = rotateRight(root->right);
+        return rotateLeft(root);
+    }
+    return root;
 }
 
 /**
  * @brief Remove node from BST by ID if found (BST removal logic).
+ * @param arena the owner's arena the removed node goes back to
  * @param root BST root
  * @param id ID to remove
+ * @param removed set to 1 if a node was removed, untouched otherwise (may be NULL)
  * @return updated BST root
  * Why we made it: We handle special cases of a BST remove (0,1,2 children).
  */
-PokemonNode *removeNodeBST(PokemonNode *root, int id)
+PokemonNode *removeNodeBST(PokemonArena *arena, PokemonNode *root, int id, int *removed)
 {
-    if(root == NULL || id <= 0 || id > 151)
-        return NULL;
+    if(root == NULL || id <= 0 || id > MAX_POKEMON_ID)
+        return root;
+    STAT_COUNT(nodeVisits, 1);
+    STAT_COUNT(comparisons, 1);
     int currentId = root->data->id;
     if(currentId > id)
     {
-        root->left = removeNodeBST(root->left, id);
-        return root;
+        root->left = removeNodeBST(arena, root->left, id, removed);
+        return rebalance(root);
     }
     if(currentId < id)
     {
-        root->right = removeNodeBST(root->right, id);
-        return root;
+        root->right = removeNodeBST(arena, root->right, id, removed);
+        return rebalance(root);
     }
+    if(removed != NULL)
+        *removed = 1;
     if(root->left == NULL && root->right == NULL)
     {
-        freePokemonNode(root);
+        freePokemonNode(arena, root);
         root = NULL;
         return NULL;
     }
@@ -594,20 +1085,20 @@ PokemonNode *removeNodeBST(PokemonNode *root, int id)
     {
         PokemonNode *temp = root;
         root = root->right;
-        freePokemonNode(temp);
+        freePokemonNode(arena, temp);
         return root;
     }
     if(root->right == NULL)
     {
         PokemonNode *temp = root;
         root = root->left;
-        freePokemonNode(temp);
+        freePokemonNode(arena, temp);
         return root;
     }
     PokemonNode *successor = findMin(root->right);
     root->data = successor->data;
-    root->right = removeNodeBST(root->right, successor->data->id);
-    return root;
+    root->right = removeNodeBST(arena, root->right, successor->data->id, NULL);
+    return rebalance(root);
 }
 
 /**finds a replacement to the pokemon we want to release when that node has 2 children*/
@@ -615,25 +1106,61 @@ PokemonNode *findMin(PokemonNode *root)
 {
     if(root == NULL)
         return NULL;
-    if(root->left == NULL)
-        return root;
-    return findMin(root->left);
+    while(root->left != NULL)
+        root = root->left;
+    return root;
+}
+
+/**writes the tree's nodes into out sorted by ID (in-order) and returns how many, out needs room for MAX_POKEMON_ID nodes*/
+int flattenPokedex(PokemonNode *root, PokemonNode **out)
+{
+    PokemonNode *stack[MAX_TREE_HEIGHT];
+    int top = 0;
+    int count = 0;
+    PokemonNode *current = root;
+    while(current != NULL || top > 0)
+    {
+        while(current != NULL)
+        {
+            stack[top++] = current;
+            current = current->left;
+        }
+        STAT_MAX(maxDepth, top);
+        current = stack[--top];
+        out[count++] = current;
+        current = current->right;
+    }
+    return count;
+}
+
+/**links nodes already sorted by ID into a balanced BST in O(count), returns the root*/
+PokemonNode *buildBalancedTree(PokemonNode **nodes, int count)
+{
+    if(count <= 0)
+        return NULL;
+    STAT_COUNT(nodeVisits, 1);
+    int middle = count / 2;
+    PokemonNode *root = nodes[middle];
+    root->left = buildBalancedTree(nodes, middle);
+    root->right = buildBalancedTree(nodes + middle + 1, count - middle - 1);
+    updateHeight(root);
+    return root;
 }
 
 /**
- * @brief Combine BFS search + BST removal to remove Pokemon by ID.
+ * @brief Remove a Pokemon by ID in a single descent (find and remove together).
+ * @param arena the owner's arena the removed node goes back to
  * @param root BST root
  * @param id the ID to remove
+ * @param removed set to 1 if the Pokemon was found and removed, 0 otherwise (may be NULL)
  * @return updated BST root
- * Why we made it: BFS confirms existence, then removeNodeBST does the removal.
+ * Why we made it: Releasing shouldn't search first and then walk the tree again to remove.
  */
-PokemonNode *removePokemonByID(PokemonNode *root, int id)
+PokemonNode *removePokemonByID(PokemonArena *arena, PokemonNode *root, int id, int *removed)
 {
-    if (root == NULL)
-        return NULL;
-    if(searchPokemonBFS(root, id) == NULL)
-        return root;
-    return removeNodeBST(root, id);
+    if(removed != NULL)
+        *removed = 0;
+    return removeNodeBST(arena, root, id, removed);
 }
 
 /* ------------------------------------------------------------
@@ -655,26 +1182,61 @@ void BFSGeneric(PokemonNode *root, VisitNodeFunc visit)
 {
     if(root == NULL)
         return;
-    int height = pokedexHeight(root);
-    for(int i = 1 ; i <= height ; i++)
-        genericPokemonByLevel(root, i, visit);
-}
-
-/**goes over the bst by level by searching for a specific level (distance from the root) to print*/
-void genericPokemonByLevel(PokemonNode *root, int level, VisitNodeFunc visit)
-{
-    if(root == NULL)
-        return;
-    if(level == 1)
-        visit(root);
-    else
+    bfsQueue.head = 0;
+    bfsQueue.tail = 0;
+    enqueuePokemon(&bfsQueue, root);
+    PokemonNode *current;
+    while((current = dequeuePokemon(&bfsQueue)) != NULL)
     {
-        genericPokemonByLevel(root->left, level - 1, visit);
-        genericPokemonByLevel(root->right, level - 1, visit);
+        STAT_COUNT(nodeVisits, 1);
+        STAT_MAX(maxDepth, bfsQueue.tail - bfsQueue.head);
+        // children are queued before visiting, same left-to-right level order as before
+        if(current->left != NULL)
+            enqueuePokemon(&bfsQueue, current->left);
+        if(current->right != NULL)
+            enqueuePokemon(&bfsQueue, current->right);
+        visit(current);
     }
 }
 
-/**
+/**adds a node to the back of the queue, growing the buffer if it's full*/
+void enqueuePokemon(PokemonQueue *queue, PokemonNode *node)
+{
+    if(queue->tail == queue->capacity)
+    {
+        int newCapacity = queue->capacity == 0 ? QUEUE_START_CAPACITY : queue->capacity * 2;
+        PokemonNode **temp = (PokemonNode **)realloc(queue->nodes, newCapacity * sizeof(PokemonNode *));
+        STAT_COUNT(mallocs, 1);
+        if(temp == NULL)
+        {
+            printf("Memory reallocation failed.\n");
+            return;
+        }
+        queue->nodes = temp;
+        queue->capacity = newCapacity;
+    }
+    queue->nodes[queue->tail++] = node;
+}
+
+/**takes the node at the front of the queue, NULL when the queue is empty*/
+PokemonNode *dequeuePokemon(PokemonQueue *queue)
+{
+    if(queue->head == queue->tail)
+        return NULL;
+    return queue->nodes[queue->head++];
+}
+
+/**frees the queue buffer (the nodes themselves belong to their tree)*/
+void freePokemonQueue(PokemonQueue *queue)
+{
+    free(queue->nodes);
+    queue->nodes = NULL;
+    queue->head = 0;
+    queue->tail = 0;
+    queue->capacity = 0;
+}
+
+/**
  * @brief A generic pre-order traversal (Root-Left-Right).
  * @param root BST root
  * @param visit function pointer
@@ -682,11 +1244,23 @@ void genericPokemonByLevel(PokemonNode *root, int level, VisitNodeFunc visit)
  */
 void preOrderGeneric(PokemonNode *root, VisitNodeFunc visit)
 {
+    PokemonNode *stack[MAX_TREE_HEIGHT + 1];
+    int top = 0;
     if(root == NULL)
         return;
-    visit(root);
-    preOrderGeneric(root->left, visit);
-    preOrderGeneric(root->right, visit);
+    stack[top++] = root;
+    while(top > 0)
+    {
+        PokemonNode *current = stack[--top];
+        // right goes in first so the left subtree comes out first
+        if(current->right != NULL)
+            stack[top++] = current->right;
+        if(current->left != NULL)
+            stack[top++] = current->left;
+        STAT_COUNT(nodeVisits, 1);
+        STAT_MAX(maxDepth, top);
+        visit(current);
+    }
 }
 
 /**
@@ -697,11 +1271,24 @@ void preOrderGeneric(PokemonNode *root, VisitNodeFunc visit)
  */
 void inOrderGeneric(PokemonNode *root, VisitNodeFunc visit)
 {
-    if(root == NULL)
-        return;
-    inOrderGeneric(root->left, visit);
-    visit(root);
-    inOrderGeneric(root->right, visit);
+    PokemonNode *stack[MAX_TREE_HEIGHT];
+    int top = 0;
+    PokemonNode *current = root;
+    while(current != NULL || top > 0)
+    {
+        // walk down the left spine, then visit on the way back up
+        while(current != NULL)
+        {
+            stack[top++] = current;
+            current = current->left;
+        }
+        STAT_MAX(maxDepth, top);
+        current = stack[--top];
+        STAT_COUNT(nodeVisits, 1);
+        PokemonNode *next = current->right;
+        visit(current);
+        current = next;
+    }
 }
 
 /**
@@ -712,11 +1299,27 @@ void inOrderGeneric(PokemonNode *root, VisitNodeFunc visit)
  */
 void postOrderGeneric(PokemonNode *root, VisitNodeFunc visit)
 {
-    if(root == NULL)
-        return;
-    postOrderGeneric(root->left, visit);
-    postOrderGeneric(root->right, visit);
-    visit(root);
+    PokemonNode *stack[MAX_TREE_HEIGHT];
+    int top = 0;
+    PokemonNode *current = root;
+    while(1)
+    {
+        // go down to the first node to visit: keep left, take right only where there's no left
+        while(current != NULL)
+        {
+            stack[top++] = current;
+            current = current->left != NULL ? current->left : current->right;
+        }
+        if(top == 0)
+            return;
+        STAT_MAX(maxDepth, top);
+        PokemonNode *done = stack[--top];
+        STAT_COUNT(nodeVisits, 1);
+        visit(done);
+        // coming back up from a left subtree means the right one is next
+        if(top > 0 && stack[top - 1]->left == done)
+            current = stack[top - 1]->right;
+    }
 }
 
 /**
@@ -739,6 +1342,7 @@ void initNodeArray(NodeArray *na, int cap)
 {
     na->capacity = cap;
     na->nodes = (PokemonNode **)malloc(cap * sizeof(PokemonNode *));
+    STAT_COUNT(mallocs, 1);
     if(na->nodes == NULL)
     {
         printf("Memory allocation failed.\n");
@@ -757,31 +1361,43 @@ void addNode(NodeArray *na, PokemonNode *node)
 {
     if(na->size == na->capacity)
     {
-        na->nodes = (PokemonNode**)realloc(na->nodes, (na->capacity * 2) * sizeof(PokemonNode*));
-        if(na->nodes == NULL)
+        int newCapacity = na->capacity > 0 ? na->capacity * 2 : 1;
+        PokemonNode **temp = (PokemonNode**)realloc(na->nodes, newCapacity * sizeof(PokemonNode*));
+        STAT_COUNT(mallocs, 1);
+        if(temp == NULL)
         {
             printf("Memory reallocation failed.\n");
-            free(na->nodes);
             return;
         }
+        na->nodes = temp;
+        na->capacity = newCapacity;
     }
     na->nodes[na->size] = node;
     na->size++;
 }
 
 /**
- * @brief Recursively collect all nodes from the BST into a NodeArray.
+ * @brief Collect all nodes from the BST into a NodeArray (pre-order, explicit stack).
  * @param root BST root
  * @param na pointer to NodeArray
  * Why we made it: We gather everything for qsort.
  */
 void collectAll(PokemonNode *root, NodeArray *na)
 {
+    PokemonNode *stack[MAX_TREE_HEIGHT + 1];
+    int top = 0;
     if(root == NULL)
         return;
-    addNode(na, root);
-    collectAll(root->left, na);
-    collectAll(root->right, na);
+    stack[top++] = root;
+    while(top > 0)
+    {
+        PokemonNode *current = stack[--top];
+        addNode(na, current);
+        if(current->right != NULL)
+            stack[top++] = current->right;
+        if(current->left != NULL)
+            stack[top++] = current->left;
+    }
 }
 
 /**
@@ -810,28 +1426,54 @@ void displayAlphabetical(PokemonNode *root)
 {
     if(root == NULL)
         return;
-    NodeArray *array = (NodeArray*)malloc(sizeof(NodeArray));
-    initNodeArray(array, pokedexHeight(root));
-    collectAll(root, array);
-
-    for(int i = 0; i < array->size - 1; i++)
+    // an owner has each species at most once, so every node gets its own rank bucket
+    PokemonNode *nodes[MAX_POKEMON_ID];
+    PokemonNode *byRank[MAX_POKEMON_ID] = {NULL};
+    int count = flattenPokedex(root, nodes);
+    for(int i = 0; i < count; i++)
+        byRank[nameRank[nodes[i]->data->id]] = nodes[i];
+    for(int rank = 0; rank < MAX_POKEMON_ID; rank++)
     {
-        for(int j = 0; j < array->size - i - 1; j++)
-        {
-            if(compareByNameNode(&array->nodes[j], &array->nodes[j + 1]) == 1)
-            {
-                PokemonNode *temp = array->nodes[j];
-                array->nodes[j] = array->nodes[j + 1];
-                array->nodes[j + 1] = temp;
-            }
-        }
+        if(byRank[rank] != NULL)
+            printPokemonNode(byRank[rank]);
     }
-    for(int i = 0; i < array->size; i++)
+}
+
+/**compares two species (const PokemonData**) by name, for sorting the pokedex once in initNameRanks*/
+int compareSpeciesByName(const void *a, const void *b)
+{
+    const PokemonData *speciesA = *(const PokemonData **)a;
+    const PokemonData *speciesB = *(const PokemonData **)b;
+    return strcmp(speciesA->name, speciesB->name);
+}
+
+/**fills nameRank[] with every species' alphabetical position, called once at startup*/
+void initNameRanks()
+{
+    const PokemonData *species[MAX_POKEMON_ID];
+    for(int i = 0; i < MAX_POKEMON_ID; i++)
+        species[i] = &pokedex[i];
+    qsort(species, MAX_POKEMON_ID, sizeof(species[0]), compareSpeciesByName);
+    for(int rank = 0; rank < MAX_POKEMON_ID; rank++)
+        nameRank[species[rank]->id] = rank;
+}
+
+void initSpeciesTable()
+{
+    memset(&speciesTable, 0, sizeof(speciesTable));
+    for(int i = 0; i < MAX_POKEMON_ID; i++)
     {
-        printPokemonNode(array->nodes[i]);
+        int id = pokedex[i].id;
+        speciesTable.hp[id] = pokedex[i].hp;
+        speciesTable.attack[id] = pokedex[i].attack;
+        speciesTable.type[id] = (uint8_t)pokedex[i].TYPE;
+        speciesTable.canEvolve[id] = (uint8_t)pokedex[i].CAN_EVOLVE;
     }
-    free(array->nodes);
-    free(array);
+}
+
+double speciesScore(int id)
+{
+    return speciesTable.attack[id] * 1.5 + speciesTable.hp[id] * 1.2;
 }
 
 /* ------------------------------------------------------------
@@ -854,14 +1496,19 @@ void pokemonFight(OwnerNode *owner)
     }
     int firstId = readIntSafe("Enter ID of the first Pokemon: ");
     int secondId = readIntSafe("Enter ID of the second Pokemon: ");
-    if(searchPokemonBFS(owner->pokedexRoot, firstId) == NULL ||
-        searchPokemonBFS(owner->pokedexRoot, secondId) == NULL)
+    fightPokemonByID(owner, firstId, secondId);
+}
+
+void fightPokemonByID(OwnerNode *owner, int firstId, int secondId)
+{
+    STAT_BEGIN(STAT_OP_FIGHT);
+    if(!ownsPokemon(owner, firstId) || !ownsPokemon(owner, secondId))
     {
         printf("One or both Pokemon IDs not found.\n");
         return;
     }
-    double firstPokemon = pokedex[firstId - 1].attack * 1.5 + pokedex[firstId - 1].hp * 1.2;
-    double secondPokemon = pokedex[secondId - 1].attack * 1.5 + pokedex[secondId - 1].hp * 1.2;
+    double firstPokemon = speciesScore(firstId);
+    double secondPokemon = speciesScore(secondId);
     printf("Pokemon 1: %s (Score = %.2f)\n", pokedex[firstId - 1].name, firstPokemon);
     printf("Pokemon 2: %s (Score = %.2f)\n", pokedex[secondId - 1].name, secondPokemon);
     if(firstPokemon > secondPokemon)
@@ -884,25 +1531,294 @@ void evolvePokemon(OwnerNode *owner)
         printf("Cannot evolve. Pokedex empty.\n");
         return;
     }
-    int id = readIntSafe("Enter ID of Pokemon to evolve: ");
-    if(searchPokemonBFS(owner->pokedexRoot, id) == NULL)
+    evolvePokemonByID(owner, readIntSafe("Enter ID of Pokemon to evolve: "));
+}
+
+void evolvePokemonByID(OwnerNode *owner, int id)
+{
+    switch (applyEvolvePokemon(owner, id))
     {
+    case OP_OK:
+        printf("Pokemon evolved from %s (ID %d) to %s (ID %d).\n", pokedex[id - 1].name, id, pokedex[id + 1 - 1].name, id + 1);
+        break;
+    case OP_CANNOT_EVOLVE:
+        printf("Cannot evolve.\n");
+        break;
+    default:
         printf("No Pokemon with ID %d found.\n", id);
+    }
+}
+
+OpResult applyEvolvePokemon(OwnerNode *owner, int id)
+{
+    STAT_BEGIN(STAT_OP_EVOLVE);
+    if(!ownsPokemon(owner, id))
+        return OP_NOT_FOUND;
+    if(speciesTable.canEvolve[id] == CANNOT_EVOLVE)
+        return OP_CANNOT_EVOLVE;
+    owner->pokedexRoot = removeNodeBST(&owner->arena, owner->pokedexRoot, id, NULL);
+    unmarkPokemonOwned(owner, id);
+    if(!ownsPokemon(owner, id + 1))
+    {
+        PokemonNode *evolved = createPokemonNode(&owner->arena, &pokedex[id]);
+        owner->pokedexRoot = insertPokemonNode(&owner->arena, owner->pokedexRoot, evolved);
+        markPokemonOwned(owner, id + 1);
+    }
+    journalRecord('E', owner->ownerName, NULL, id);
+    STAT_MAX(maxHeight, pokedexHeight(owner->pokedexRoot));
+    return OP_OK;
+}
+
+void evolveAllMenu(OwnerNode *owner)
+{
+    if(owner == NULL)
+        return;
+    if(owner->pokedexRoot == NULL)
+    {
+        printf("Cannot evolve. Pokedex empty.\n");
         return;
     }
-    if(pokedex[id - 1].CAN_EVOLVE == CANNOT_EVOLVE)
+    printf("1. One step\n");
+    printf("2. To final form\n");
+    int choice = readIntSafe("Your choice: ");
+    if(choice != 1 && choice != 2)
     {
-        printf("Cannot evolve.\n");
+        printf("Invalid choice.\n");
+        return;
+    }
+    evolveAllByOwner(owner, choice == 2);
+}
+
+void evolveAllByOwner(OwnerNode *owner, int toFinal)
+{
+    int evolved = applyEvolveAll(owner, toFinal);
+    if(evolved == 0)
+        printf("Nothing to evolve.\n");
+    else
+        printf("Evolved %d Pokemon in %s's Pokedex.\n", evolved, owner->ownerName);
+}
+
+int applyEvolveAll(OwnerNode *owner, int toFinal)
+{
+    STAT_BEGIN(STAT_OP_EVOLVE_ALL);
+    PokemonNode *nodes[MAX_POKEMON_ID];
+    int count = flattenPokedex(owner->pokedexRoot, nodes);
+    int kept = 0;
+    int evolved = 0;
+    for(int i = 0; i < count; i++)
+    {
+        int id = nodes[i]->data->id;
+        int target = id;
+        if(speciesTable.canEvolve[target] == CAN_EVOLVE)
+            target++;
+        while(toFinal && speciesTable.canEvolve[target] == CAN_EVOLVE)
+            target++;
+        if(target != id)
+        {
+            evolved++;
+            unmarkPokemonOwned(owner, id);
+            nodes[i]->data = &pokedex[target - 1];
+        }
+        // the new IDs come out in order, so a duplicate can only be the last one kept
+        if(kept > 0 && nodes[kept - 1]->data->id == target)
+            freePokemonNode(&owner->arena, nodes[i]);
+        else
+            nodes[kept++] = nodes[i];
+    }
+    if(evolved == 0)
+        return 0;
+    for(int i = 0; i < kept; i++)
+        markPokemonOwned(owner, nodes[i]->data->id);
+    owner->pokedexRoot = buildBalancedTree(nodes, kept);
+    journalRecord('V', owner->ownerName, NULL, toFinal);
+    STAT_MAX(maxHeight, pokedexHeight(owner->pokedexRoot));
+    return evolved;
+}
+
+void addManyMenu(OwnerNode *owner)
+{
+    if(owner == NULL)
+        return;
+    printf("Enter IDs to add (like 1-30,45,100-151): ");
+    char *list = getDynamicInput();
+    if(list == NULL)
+        return;
+    uint32_t ids[OWNED_WORDS];
+    if(parseIdRanges(list, ids))
+        addManyByOwner(owner, ids);
+    else
+        printf("Invalid ID list.\n");
+    free(list);
+}
+
+void addManyByOwner(OwnerNode *owner, const uint32_t *ids)
+{
+    int requested = 0;
+    for(int id = 1; id <= MAX_POKEMON_ID; id++)
+        requested += (ids[id / 32] >> (id % 32)) & 1u;
+    int added = applyAddMany(owner, ids);
+    printf("Added %d Pokemon to %s's Pokedex, %d already there.\n", added, owner->ownerName, requested - added);
+}
+
+int applyAddMany(OwnerNode *owner, const uint32_t *ids)
+{
+    STAT_BEGIN(STAT_OP_ADD_MANY);
+    PokemonNode *existing[MAX_POKEMON_ID];
+    PokemonNode *merged[MAX_POKEMON_ID];
+    uint32_t added[OWNED_WORDS] = {0};
+    int count = flattenPokedex(owner->pokedexRoot, existing);
+    int next = 0, total = 0, addedCount = 0;
+    for(int id = 1; id <= MAX_POKEMON_ID; id++)
+    {
+        if(!((ids[id / 32] >> (id % 32)) & 1u) || ownsPokemon(owner, id))
+            continue;
+        PokemonNode *node = createPokemonNode(&owner->arena, &pokedex[id - 1]);
+        if(node == NULL)
+            break;
+        while(next < count && existing[next]->data->id < id)
+            merged[total++] = existing[next++];
+        merged[total++] = node;
+        added[id / 32] |= 1u << (id % 32);
+        addedCount++;
+    }
+    if(addedCount == 0)
+        return 0;
+    while(next < count)
+        merged[total++] = existing[next++];
+    for(int w = 0; w < OWNED_WORDS; w++)
+        owner->ownedIds[w] |= added[w];
+    owner->pokedexRoot = buildBalancedTree(merged, total);
+    journalRecordIds('B', owner->ownerName, added);
+    STAT_MAX(maxHeight, pokedexHeight(owner->pokedexRoot));
+    return addedCount;
+}
+
+void releaseWhereMenu(OwnerNode *owner)
+{
+    if(owner == NULL)
+        return;
+    if(owner->pokedexRoot == NULL)
+    {
+        printf("No Pokemon to release.\n");
+        return;
+    }
+    printf("1. By type\n");
+    printf("2. HP below\n");
+    printf("3. Attack between\n");
+    printf("4. Can evolve\n");
+    printf("5. Cannot evolve\n");
+    ReleasePredicate predicate = {RELEASE_TYPE, 0, 0};
+    switch (readIntSafe("Your choice: "))
+    {
+    case 1:
+    {
+        printf("Type: ");
+        char *name = getDynamicInput();
+        if(name == NULL)
+            return;
+        predicate.low = parseTypeName(name);
+        free(name);
+        if(predicate.low < 0)
+        {
+            printf("Unknown type.\n");
+            return;
+        }
+        break;
+    }
+    case 2:
+        predicate.rule = RELEASE_HP_BELOW;
+        predicate.low = readIntSafe("Release Pokemon with HP below: ");
+        break;
+    case 3:
+        predicate.rule = RELEASE_ATTACK_RANGE;
+        predicate.low = readIntSafe("Lowest attack: ");
+        predicate.high = readIntSafe("Highest attack: ");
+        // same rule as parseReleasePredicate in batch mode
+        if(predicate.low > predicate.high)
+        {
+            printf("Invalid attack range.\n");
+            return;
+        }
+        break;
+    case 4:
+        predicate.rule = RELEASE_CAN_EVOLVE;
+        break;
+    case 5:
+        predicate.rule = RELEASE_CANNOT_EVOLVE;
+        break;
+    default:
+        printf("Invalid choice.\n");
         return;
     }
-    owner->pokedexRoot = removeNodeBST(owner->pokedexRoot, id);
-    if(searchPokemonBFS(owner->pokedexRoot, id + 1) == NULL)
+    releaseWhereByOwner(owner, &predicate);
+}
+
+void releaseWhereByOwner(OwnerNode *owner, const ReleasePredicate *predicate)
+{
+    uint32_t ids[OWNED_WORDS];
+    speciesMatching(predicate, ids);
+    int released = applyReleaseMany(owner, ids);
+    if(released == 0)
+        printf("No Pokemon matched.\n");
+    else
+        printf("Released %d Pokemon from %s's Pokedex.\n", released, owner->ownerName);
+}
+
+void speciesMatching(const ReleasePredicate *predicate, uint32_t *ids)
+{
+    uint8_t match[SPECIES_TABLE_SIZE];
+    switch (predicate->rule)
+    {
+    case RELEASE_TYPE:
+        for(int id = 0; id < SPECIES_TABLE_SIZE; id++)
+            match[id] = speciesTable.type[id] == predicate->low;
+        break;
+    case RELEASE_HP_BELOW:
+        for(int id = 0; id < SPECIES_TABLE_SIZE; id++)
+            match[id] = speciesTable.hp[id] < predicate->low;
+        break;
+    case RELEASE_ATTACK_RANGE:
+        for(int id = 0; id < SPECIES_TABLE_SIZE; id++)
+            match[id] = speciesTable.attack[id] >= predicate->low && speciesTable.attack[id] <= predicate->high;
+        break;
+    default:
+    {
+        int wanted = predicate->rule == RELEASE_CAN_EVOLVE ? CAN_EVOLVE : CANNOT_EVOLVE;
+        for(int id = 0; id < SPECIES_TABLE_SIZE; id++)
+            match[id] = speciesTable.canEvolve[id] == wanted;
+    }
+    }
+    // slot 0 and the padding aren't species, whatever their zeroes matched
+    memset(ids, 0, OWNED_WORDS * sizeof(uint32_t));
+    for(int id = 1; id <= MAX_POKEMON_ID; id++)
+        ids[id / 32] |= (uint32_t)match[id] << (id % 32);
+}
+
+int applyReleaseMany(OwnerNode *owner, const uint32_t *ids)
+{
+    STAT_BEGIN(STAT_OP_RELEASE_MANY);
+    PokemonNode *nodes[MAX_POKEMON_ID];
+    uint32_t released[OWNED_WORDS];
+    int count = flattenPokedex(owner->pokedexRoot, nodes);
+    int kept = 0;
+    for(int w = 0; w < OWNED_WORDS; w++)
+        released[w] = owner->ownedIds[w] & ids[w];
+    for(int i = 0; i < count; i++)
     {
-        PokemonNode *temp = createPokemonNode(&pokedex[id]);
-        owner->pokedexRoot = insertPokemonNode(owner->pokedexRoot, temp);
-        freePokemonNode(temp);
+        int id = nodes[i]->data->id;
+        if((released[id / 32] >> (id % 32)) & 1u)
+            freePokemonNode(&owner->arena, nodes[i]);
+        else
+            nodes[kept++] = nodes[i];
     }
-    printf("Pokemon evolved from %s (ID %d) to %s (ID %d).\n", pokedex[id - 1].name, id, pokedex[id + 1 - 1].name, id + 1);
+    if(kept == count)
+        return 0;
+    for(int w = 0; w < OWNED_WORDS; w++)
+        owner->ownedIds[w] &= ~released[w];
+    owner->pokedexRoot = buildBalancedTree(nodes, kept);
+    journalRecordIds('X', owner->ownerName, released);
+    STAT_MAX(maxHeight, pokedexHeight(owner->pokedexRoot));
+    return count - kept;
 }
 
 /**
@@ -912,22 +1828,41 @@ void evolvePokemon(OwnerNode *owner)
  */
 void addPokemon(OwnerNode *owner)
 {
-    int pokemonId = readIntSafe("Enter ID to add: ");
-    if(pokemonId <= 0 || pokemonId > 151)
+    addPokemonByID(owner, readIntSafe("Enter ID to add: "));
+}
+
+void addPokemonByID(OwnerNode *owner, int id)
+{
+    switch (applyAddPokemon(owner, id))
     {
+    case OP_OK:
+        printf("Pokemon %s (ID %d) added.\n", pokedex[id - 1].name, id);
+        break;
+    case OP_ALREADY_OWNED:
+        printf("Pokemon with ID %d is already in the Pokedex. No changes made.\n", id);
+        break;
+    case OP_NO_MEMORY:
+        break;
+    default:
         printf("Invalid ID.\n");
-        return;
     }
-    PokemonNode *temp = searchPokemonBFS(owner->pokedexRoot, pokemonId);
-    if(temp != NULL)
-    {
-        printf("Pokemon with ID %d is already in the Pokedex. No changes made.\n", pokemonId);
-        return;
-    }
-    PokemonNode *newPokemon = createPokemonNode(&pokedex[pokemonId - 1]);
-    owner->pokedexRoot = insertPokemonNode(owner->pokedexRoot, newPokemon);
-    freePokemonNode(newPokemon);
-    printf("Pokemon %s (ID %d) added.\n", newPokemon->data->name, pokemonId);
+}
+
+OpResult applyAddPokemon(OwnerNode *owner, int id)
+{
+    STAT_BEGIN(STAT_OP_ADD);
+    if(id <= 0 || id > MAX_POKEMON_ID)
+        return OP_INVALID_ID;
+    if(ownsPokemon(owner, id))
+        return OP_ALREADY_OWNED;
+    PokemonNode *newPokemon = createPokemonNode(&owner->arena, &pokedex[id - 1]);
+    if(newPokemon == NULL)
+        return OP_NO_MEMORY;
+    owner->pokedexRoot = insertPokemonNode(&owner->arena, owner->pokedexRoot, newPokemon);
+    markPokemonOwned(owner, id);
+    journalRecord('A', owner->ownerName, NULL, id);
+    STAT_MAX(maxHeight, pokedexHeight(owner->pokedexRoot));
+    return OP_OK;
 }
 
 /**
@@ -942,18 +1877,31 @@ void freePokemon(OwnerNode *owner)
         printf("No Pokemon to release.\n");
         return;
     }
-    int pokemonId = readIntSafe("Enter Pokemon ID to release: ");
-    if(searchPokemonBFS(owner->pokedexRoot, pokemonId) != NULL)
-    {
-        owner->pokedexRoot = removePokemonByID(owner->pokedexRoot, pokemonId);
-        printf("Removing Pokemon %s (ID %d).\n", pokedex[pokemonId - 1].name, pokemonId);
-    }
+    releasePokemonByID(owner, readIntSafe("Enter Pokemon ID to release: "));
+}
+
+void releasePokemonByID(OwnerNode *owner, int id)
+{
+    if(applyReleasePokemon(owner, id) == OP_OK)
+        printf("Removing Pokemon %s (ID %d).\n", pokedex[id - 1].name, id);
     else
-        printf("Pokemon with ID %d not found.\n", pokemonId);
+        printf("Pokemon with ID %d not found.\n", id);
+}
+
+OpResult applyReleasePokemon(OwnerNode *owner, int id)
+{
+    STAT_BEGIN(STAT_OP_RELEASE);
+    if(!ownsPokemon(owner, id))
+        return OP_NOT_FOUND;
+    owner->pokedexRoot = removePokemonByID(&owner->arena, owner->pokedexRoot, id, NULL);
+    unmarkPokemonOwned(owner, id);
+    journalRecord('R', owner->ownerName, NULL, id);
+    STAT_MAX(maxHeight, pokedexHeight(owner->pokedexRoot));
+    return OP_OK;
 }
 
 /* ------------------------------------------------------------
-   8) Sorting Owners (Bubble Sort on Circular List)
+   8) Sorting Owners (Merge Sort on Circular List)
    ------------------------------------------------------------ */
 
 /**
@@ -962,40 +1910,81 @@ void freePokemon(OwnerNode *owner)
  */
 void sortOwners()
 {
+    if(applySortOwners())
+        printf("Owners sorted by name.\n");
+    else
+        printf("0 or 1 owners only => no need to sort.\n");
+}
+
+int applySortOwners()
+{
+    STAT_BEGIN(STAT_OP_SORT);
     int amount = ownersAmount();
     if(amount == 0 || amount == 1)
+        return 0;
+    // open the ring, sort it as a plain list, then restore prev links and close it
+    ownerHead->prev->next = NULL;
+    ownerHead = mergeSortOwners(ownerHead, amount);
+    OwnerNode *previous = ownerHead;
+    OwnerNode *current = ownerHead->next;
+    while(current != NULL)
     {
-        printf("0 or 1 owners only => no need to sort.\n");
-        return;
-    }
-    for(int i = 0 ; i < amount ; i++)
-    {
-        OwnerNode* temp = ownerHead;
-        for(int j = 0 ; j < amount - i; j++, temp = temp->next)
-        {
-            if(strcmp(temp->ownerName, temp->next->ownerName) > 0)
-            {
-                swapOwnerData(temp, temp->next);
-            }
-        }
+        current->prev = previous;
+        previous = current;
+        current = current->next;
     }
-    printf("Owners sorted by name.\n");
+    previous->next = ownerHead;
+    ownerHead->prev = previous;
+    journalRecord('S', NULL, NULL, 0);
+    return 1;
 }
 
 /**
- * @brief Helper to swap name & pokedexRoot in two OwnerNode.
- * @param a pointer to first owner
- * @param b pointer to second owner
- * Why we made it: Used internally by bubble sort to swap data.
+ * @brief Merge sort a NULL-terminated list of owners (linked by next only) by name.
+ * @param list first owner of the list
+ * @param length how many owners are in the list
+ * @return first owner of the sorted list (prev pointers are not fixed here)
+ * Why we made it: sortOwners opens the ring, sorts it with this, then closes it again.
  */
-void swapOwnerData(OwnerNode *a, OwnerNode *b)
+OwnerNode *mergeSortOwners(OwnerNode *list, int length)
+{
+    if(length <= 1)
+    {
+        if(list != NULL)
+            list->next = NULL;
+        return list;
+    }
+    int half = length / 2;
+    OwnerNode *secondHalf = list;
+    for(int i = 0; i < half; i++)
+        secondHalf = secondHalf->next;
+    OwnerNode *first = mergeSortOwners(list, half);
+    OwnerNode *second = mergeSortOwners(secondHalf, length - half);
+    return mergeOwnerLists(first, second);
+}
+
+/**merges two name-sorted owner lists (linked by next) into one and returns its first owner*/
+OwnerNode *mergeOwnerLists(OwnerNode *a, OwnerNode *b)
 {
-    PokemonNode* temp = a->pokedexRoot;
-    a->pokedexRoot = b->pokedexRoot;
-    b->pokedexRoot = temp;
-    char* tempName = a->ownerName;
-    a->ownerName = b->ownerName;
-    b->ownerName = tempName;
+    OwnerNode *head = NULL;
+    OwnerNode **tail = &head;
+    while(a != NULL && b != NULL)
+    {
+        STAT_COUNT(comparisons, 1);
+        if(strcmp(a->ownerName, b->ownerName) <= 0)
+        {
+            *tail = a;
+            a = a->next;
+        }
+        else
+        {
+            *tail = b;
+            b = b->next;
+        }
+        tail = &(*tail)->next;
+    }
+    *tail = a != NULL ? a : b;
+    return head;
 }
 
 /** returns the amount of owners in the circular linked list for the sort function*/
@@ -1022,10 +2011,10 @@ int ownersAmount()
  * @param newOwner pointer to newly created OwnerNode
  * Why we made it: We need a standard approach to keep the list circular.
  */
-void linkOwnerInCircularList(OwnerNode *newOwner)
+int linkOwnerInCircularList(OwnerNode *newOwner)
 {
-    if (newOwner == NULL)
-        return;
+    if (newOwner == NULL || !indexOwner(newOwner))
+        return 0;
     if (ownerHead == NULL)
     {
         ownerHead = newOwner;
@@ -1046,6 +2035,7 @@ void linkOwnerInCircularList(OwnerNode *newOwner)
         ownerHead->prev = newOwner;
         newOwner->next = ownerHead;
     }
+    return 1;
 }
 
 /**
@@ -1057,84 +2047,155 @@ void removeOwnerFromCircularList(OwnerNode *target)
 {
     if (target == NULL || ownerHead == NULL)
         return;
-    if(target == ownerHead)
+    // every owner in the ring is indexed under its name, so this replaces walking the ring
+    if (findOwnerByName(target->ownerName) != target)
     {
-        if(ownerHead->next == ownerHead)
-        {
-            freeOwnerNode(ownerHead);
-            ownerHead = NULL;
-            return;
-        }
-        OwnerNode *temp = ownerHead;
-        ownerHead->prev->next = ownerHead->next;
-        ownerHead->next->prev = ownerHead->prev;
-        ownerHead = ownerHead->next;
-        freeOwnerNode(temp);
+        printf("owner do not exist ERROR\n");
         return;
     }
-    OwnerNode *temp = ownerHead->next;
-    while(temp != ownerHead)
+    unindexOwner(target);
+    if (target->next == target)
     {
-        if(target == temp)
-        {
-            temp->prev->next = temp->next;
-            temp->next->prev = temp->prev;
-            freeOwnerNode(temp);
-            return;
-        }
-        temp = temp->next;
+        ownerHead = NULL;
+        freeOwnerNode(target);
+        return;
     }
-    printf("owner do not exist ERROR\n");
+    target->prev->next = target->next;
+    target->next->prev = target->prev;
+    if (target == ownerHead)
+        ownerHead = target->next;
+    freeOwnerNode(target);
 }
 
 /**
  * @brief Find an owner by name in the circular list.
  * @param name string to match
  * @return pointer to the matching OwnerNode or NULL
- * Why we made it: We often need to locate an owner quickly.
+ * Why we made it: We often need to locate an owner quickly (hash lookup in ownerIndex, O(1)).
  */
 OwnerNode *findOwnerByName(const char *name)
 {
-    if (name == NULL || ownerHead == NULL)
+    if (name == NULL || ownerIndex.size == 0)
         return NULL;
-    if(strcmp(ownerHead->ownerName, name) == 0)
-        return ownerHead;
-    OwnerNode *temp = ownerHead->next;
-    while(strcmp(temp->ownerName, name) != 0 && temp != ownerHead)
+    OwnerNode *owner = ownerIndex.buckets[hashOwnerName(name) & (ownerIndex.bucketCount - 1)];
+    while (owner != NULL && strcmp(owner->ownerName, name) != 0)
+        owner = owner->hashNext;
+    return owner;
+}
+
+/**hashes an owner name (FNV-1a) for the ownerIndex buckets*/
+uint32_t hashOwnerName(const char *name)
+{
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *c = (const unsigned char *)name; *c != '\0'; c++)
     {
-        temp = temp->next;
+        hash ^= *c;
+        hash *= 16777619u;
     }
-    if (temp == ownerHead)
-        return NULL;
-    return temp;
+    return hash;
+}
+
+/**adds the owner to ownerIndex under its current name, doubling the buckets when it gets full*/
+int indexOwner(OwnerNode *owner)
+{
+    if (ownerIndex.size >= ownerIndex.bucketCount)
+    {
+        int newCount = ownerIndex.bucketCount == 0 ? INDEX_START_BUCKETS : ownerIndex.bucketCount * 2;
+        OwnerNode **newBuckets = (OwnerNode **)calloc(newCount, sizeof(OwnerNode *));
+        STAT_COUNT(mallocs, 1);
+        if (newBuckets != NULL)
+        {
+            for (int i = 0; i < ownerIndex.bucketCount; i++)
+            {
+                OwnerNode *current = ownerIndex.buckets[i];
+                while (current != NULL)
+                {
+                    OwnerNode *next = current->hashNext;
+                    uint32_t slot = hashOwnerName(current->ownerName) & (newCount - 1);
+                    current->hashNext = newBuckets[slot];
+                    newBuckets[slot] = current;
+                    current = next;
+                }
+            }
+            free(ownerIndex.buckets);
+            ownerIndex.buckets = newBuckets;
+            ownerIndex.bucketCount = newCount;
+        }
+        else
+        {
+            printf("Memory allocation failed.\n");
+            // longer chains in the old buckets are still correct; an owner missing from the index is not
+            if (ownerIndex.bucketCount == 0)
+                return 0;
+        }
+    }
+    uint32_t slot = hashOwnerName(owner->ownerName) & (ownerIndex.bucketCount - 1);
+    owner->hashNext = ownerIndex.buckets[slot];
+    ownerIndex.buckets[slot] = owner;
+    ownerIndex.size++;
+    return 1;
+}
+
+/**removes the owner from ownerIndex, call before its name changes or it's freed*/
+void unindexOwner(OwnerNode *owner)
+{
+    if (ownerIndex.size == 0)
+        return;
+    OwnerNode **link = &ownerIndex.buckets[hashOwnerName(owner->ownerName) & (ownerIndex.bucketCount - 1)];
+    while (*link != NULL && *link != owner)
+        link = &(*link)->hashNext;
+    if (*link == NULL)
+        return;
+    *link = owner->hashNext;
+    owner->hashNext = NULL;
+    ownerIndex.size--;
+}
+
+/**frees the ownerIndex buckets (the owners themselves are freed with the ring)*/
+void freeOwnerIndex()
+{
+    free(ownerIndex.buckets);
+    ownerIndex.buckets = NULL;
+    ownerIndex.bucketCount = 0;
+    ownerIndex.size = 0;
 }
 
 /* ------------------------------------------------------------
    10) Owner Menus
    ------------------------------------------------------------ */
 
-/**
- * @brief Delete an entire Pokedex (owner) from the list.
- * Why we made it: Let user pick which Pokedex to remove and free everything.
- */
-void deletePokedex()
+/**prints the numbered owner list ("1. name") through the output buffer and flushes it*/
+void printOwnerList()
 {
+    if (ownerHead == NULL)
+        return;
     int index = 1;
     OwnerNode* current = ownerHead;
-    if (current == NULL)
+    do
+    {
+        outInt(index++);
+        OUT_LITERAL(". ");
+        outString(current->ownerName, strlen(current->ownerName));
+        outChar('\n');
+        current = current->next;
+    } while (current != ownerHead);
+    outFlush();
+}
+
+/**
+ * @brief Delete an entire Pokedex (owner) from the list.
+ * Why we made it: Let user pick which Pokedex to remove and free everything.
+ */
+void deletePokedex()
+{
+    OwnerNode* current = ownerHead;
+    if (current == NULL)
     {
         printf("No existing Pokedexes to delete.\n");
         return;
     }
     printf("\n=== Delete a Pokedex ===\n");
-    printf("%d. %s\n", index, current->ownerName);
-    current = current->next;
-    while (current != ownerHead)
-    {
-        index++;
-        printf("%d. %s\n", index, current->ownerName);
-        current = current->next;
-    }
+    printOwnerList();
 
     int owner = readIntSafe("Choose a Pokedex to delete by number: ");
     current = ownerHead;
@@ -1142,13 +2203,13 @@ void deletePokedex()
         current = current->next;
 
     printf("Deleting %s's entire Pokedex...\n", current->ownerName);
-    removeOwnerFromCircularList(current);
+    applyDeleteOwner(current);
     printf("Pokedex deleted.\n");
 }
 
 /**
  * @brief Merge the second owner's Pokedex into the first, then remove the second owner.
- * Why we made it: BFS copy demonstration plus removing an owner.
+ * Why we made it: Merge demonstration plus removing an owner.
  */
 void mergePokedexMenu()
 {
@@ -1170,36 +2231,105 @@ void mergePokedexMenu()
     printf("Merging %s and %s...\n", name1, name2);
     OwnerNode* firstOwner = findOwnerByName(name1);
     OwnerNode* secondOwner = findOwnerByName(name2);
-    if (firstOwner == NULL || secondOwner == NULL)
-        return;
-
-    int height = pokedexHeight(secondOwner->pokedexRoot);
-    for (int i = 1; i <= height; i++)
+    if (firstOwner == NULL || secondOwner == NULL || firstOwner == secondOwner)
     {
-        firstOwner->pokedexRoot = insertPokemonByLevel(secondOwner->pokedexRoot, i, firstOwner->pokedexRoot);
+        free(name1);
+        free(name2);
+        return;
     }
+
+    applyMergeOwners(firstOwner, secondOwner);
     printf("Merge completed.\n");
-    removeOwnerFromCircularList(secondOwner);
     printf("Owner '%s' has been removed after merging.\n", name2);
     free(name1);
     free(name2);
 }
 
-/**goes over the pokedex of the second owner by level by searching for a specific level (distance from the root) to add to the first owner's pokedex*/
-PokemonNode* insertPokemonByLevel(PokemonNode* root, int level, PokemonNode* ownerRoot)
+/**
+ * @brief Move every Pokemon of the second owner into the first owner's Pokedex.
+ * @param first owner that keeps the merged Pokedex
+ * @param second owner whose Pokedex is emptied (its nodes are reused, not copied)
+ * Why we made it: Flatten both trees, merge the two sorted lists dropping duplicate IDs,
+ * and build one balanced tree, all in O(n + m).
+ */
+void mergeOwnerPokedexes(OwnerNode *first, OwnerNode *second)
 {
-    if(root == NULL)
-        return NULL;
-    if (level == 1)
+    PokemonNode *firstNodes[MAX_POKEMON_ID];
+    PokemonNode *secondNodes[MAX_POKEMON_ID];
+    PokemonNode *merged[MAX_POKEMON_ID];
+    int firstCount = flattenPokedex(first->pokedexRoot, firstNodes);
+    int secondCount = flattenPokedex(second->pokedexRoot, secondNodes);
+    int i = 0, j = 0, count = 0;
+    while (i < firstCount || j < secondCount)
     {
-        ownerRoot = insertPokemonNode(ownerRoot, root);
+        STAT_COUNT(comparisons, 1);
+        if (j == secondCount || (i < firstCount && firstNodes[i]->data->id < secondNodes[j]->data->id))
+            merged[count++] = firstNodes[i++];
+        else if (i == firstCount || secondNodes[j]->data->id < firstNodes[i]->data->id)
+            merged[count++] = secondNodes[j++];
+        else
+        {
+            // both have this ID, the first owner keeps theirs
+            merged[count++] = firstNodes[i++];
+            freePokemonNode(&second->arena, secondNodes[j++]);
+        }
     }
-    else
+    mergePokemonArenas(&first->arena, &second->arena);
+    first->pokedexRoot = buildBalancedTree(merged, count);
+    second->pokedexRoot = NULL;
+    for (int w = 0; w < OWNED_WORDS; w++)
     {
-        insertPokemonByLevel(root->left, level - 1, ownerRoot);
-        insertPokemonByLevel(root->right, level - 1, ownerRoot);
+        first->ownedIds[w] |= second->ownedIds[w];
+        second->ownedIds[w] = 0;
     }
-    return ownerRoot;
+}
+
+void applyMergeOwners(OwnerNode *first, OwnerNode *second)
+{
+    STAT_BEGIN(STAT_OP_MERGE);
+    journalRecord('M', first->ownerName, second->ownerName, 0);
+    mergeOwnerPokedexes(first, second);
+    removeOwnerFromCircularList(second);
+    STAT_MAX(maxHeight, pokedexHeight(first->pokedexRoot));
+}
+
+void applyDeleteOwner(OwnerNode *owner)
+{
+    STAT_BEGIN(STAT_OP_DELETE);
+    journalRecord('D', owner->ownerName, NULL, 0);
+    removeOwnerFromCircularList(owner);
+}
+
+OpResult applyNewOwner(const char *name, int starter)
+{
+    char *ownerName = myStrdup(name);
+    if (ownerName == NULL)
+        return OP_NO_MEMORY;
+    return adoptNewOwner(ownerName, starter);
+}
+
+OpResult adoptNewOwner(char *ownerName, int starter)
+{
+    STAT_BEGIN(STAT_OP_NEW);
+    if (starter < 1 || starter > 3 || findOwnerByName(ownerName) != NULL)
+    {
+        free(ownerName);
+        return starter < 1 || starter > 3 ? OP_INVALID_ID : OP_ALREADY_OWNED;
+    }
+    OwnerNode *newOwner = createOwner(ownerName, &pokedex[(starter - 1) * 3]);
+    if (newOwner == NULL)
+    {
+        free(ownerName);
+        return OP_NO_MEMORY;
+    }
+    if (!linkOwnerInCircularList(newOwner))
+    {
+        // an owner missing from the index would let a second owner take the same name
+        freeOwnerNode(newOwner);
+        return OP_NO_MEMORY;
+    }
+    journalRecord('N', ownerName, NULL, starter);
+    return OP_OK;
 }
 
 /* ------------------------------------------------------------
@@ -1217,25 +2347,44 @@ void printOwnersCircular()
         printf("No owners.\n");
         return;
     }
-    char direction;
+    char direction = '\0';
     printf("Enter direction (F or B): ");
-    scanf(" %c", &direction);
-    scanf("%*c");
+    // first non-blank character, skipping empty lines like scanf(" %c") did
+    size_t length = 0;
+    char *line;
+    while ((line = readLine(&length)) != NULL && length == 0)
+        ;
+    if (line)
+        direction = line[0];
     if (direction == 'F' || direction == 'f')
         direction = 'F';
     else if (direction == 'B' || direction == 'b')
         direction = 'B';
-    int steps = readIntSafe("How many prints? ");
+    printOwnersSteps(direction, readIntSafe("How many prints? "));
+}
+
+void printOwnersSteps(char direction, int steps)
+{
+    STAT_BEGIN(STAT_OP_PRINT);
+    if(ownerHead == NULL)
+    {
+        printf("No owners.\n");
+        return;
+    }
     OwnerNode* current = ownerHead;
     for(int i = 0 ; i < steps ; i++)
     {
-        printf("[%d] %s\n", i + 1, current->ownerName);
+        outChar('[');
+        outInt(i + 1);
+        OUT_LITERAL("] ");
+        outString(current->ownerName, strlen(current->ownerName));
+        outChar('\n');
         if(direction == 'F')
             current = current->next;
         else
             current = current->prev;
     }
-
+    outFlush();
 }
 
 /* ------------------------------------------------------------
@@ -1249,7 +2398,10 @@ void printOwnersCircular()
 void freeAllOwners()
 {
     if (ownerHead == NULL)
+    {
+        freeOwnerIndex();
         return;
+    }
     OwnerNode* current = ownerHead->next;
     OwnerNode* temp;
     while(current != ownerHead)
@@ -1260,4 +2412,1202 @@ void freeAllOwners()
     }
     freeOwnerNode(current);
     ownerHead = NULL;
-}
\ No newline at end of file
+    freeOwnerIndex();
+}
+/* ------------------------------------------------------------
+   14) Batch Mode
+   ------------------------------------------------------------ */
+
+void runBatch()
+{
+    char *words[BATCH_MAX_WORDS];
+    size_t length;
+    char *line;
+    int lineNumber = 0;
+    while ((line = readLine(&length)) != NULL)
+    {
+        lineNumber++;
+        if (length == 0 || line[0] == '#')
+            continue;
+        int count = splitCommand(line, words, BATCH_MAX_WORDS);
+        if (count < 0)
+        {
+            printf("Line %d: bad command.\n", lineNumber);
+            continue;
+        }
+        if (strcmp(words[0], "exit") == 0)
+            break;
+        runBatchCommand(words, count, lineNumber);
+    }
+}
+
+int splitCommand(char *line, char **words, int maxWords)
+{
+    int count = 0;
+    char *cursor = line;
+    while (1)
+    {
+        while (*cursor == ' ' || *cursor == '\t')
+            cursor++;
+        if (*cursor == '\0')
+            return count;
+        if (count == maxWords)
+            return -1;
+        if (*cursor == '"')
+        {
+            words[count++] = ++cursor;
+            cursor = strchr(cursor, '"');
+            if (cursor == NULL)
+                return -1;
+        }
+        else
+        {
+            words[count++] = cursor;
+            while (*cursor != '\0' && *cursor != ' ' && *cursor != '\t')
+                cursor++;
+            if (*cursor == '\0')
+                return count;
+        }
+        *cursor++ = '\0';
+    }
+}
+
+void runBatchCommand(char **words, int count, int lineNumber)
+{
+    enum
+    {
+        CMD_NEW,
+        CMD_ADD,
+        CMD_RELEASE,
+        CMD_EVOLVE,
+        CMD_FIGHT,
+        CMD_TOURNAMENT,
+        CMD_LEAGUE,
+        CMD_EVOLVE_ALL,
+        CMD_ADD_MANY,
+        CMD_RELEASE_WHERE,
+        CMD_DISPLAY,
+        CMD_DELETE,
+        CMD_MERGE,
+        CMD_SORT,
+        CMD_PRINT,
+        CMD_SAVE,
+        CMD_STATS
+    };
+    // in CMD_ order; numbers are always the last words of the command
+    static const struct
+    {
+        const char *name;
+        int words;
+        int numbers;
+        int needsOwner;
+        const char *usage;
+    } commands[] = {
+        {"new", 3, 1, 0, "new <owner> <starter 1-3>"},
+        {"add", 3, 1, 1, "add <owner> <id>"},
+        {"release", 3, 1, 1, "release <owner> <id>"},
+        {"evolve", 3, 1, 1, "evolve <owner> <id>"},
+        {"fight", 4, 2, 1, "fight <owner> <id> <id>"},
+        {"tournament", 2, 0, 1, "tournament <owner>"},
+        {"league", 1, 0, 0, "league"},
+        {"evolveall", 3, 0, 1, "evolveall <owner> once|final"},
+        {"addmany", 3, 0, 1, "addmany <owner> <ids like 1-30,45,100-151>"},
+        {"releasewhere", 3, 0, 1, "releasewhere <owner> type=FIRE|hp<50|attack=40-60|evolve=yes|evolve=no"},
+        {"display", 3, 0, 1, "display <owner> bfs|pre|in|post|alpha"},
+        {"delete", 2, 0, 1, "delete <owner>"},
+        {"merge", 3, 0, 1, "merge <first> <second>"},
+        {"sort", 1, 0, 0, "sort"},
+        {"print", 3, 1, 0, "print F|B <count>"},
+        {"save", 2, 0, 0, "save [file]"},
+#ifdef POKEDEX_STATS
+        {"stats", 1, 0, 0, "stats"},
+#endif
+    };
+    const int commandCount = (int)(sizeof(commands) / sizeof(commands[0]));
+
+    int command = 0;
+    while (command < commandCount && strcmp(words[0], commands[command].name) != 0)
+        command++;
+    if (command == commandCount)
+    {
+        printf("Line %d: unknown command '%s'.\n", lineNumber, words[0]);
+        return;
+    }
+    // save is the one command with an optional word
+    if (count != commands[command].words && !(command == CMD_SAVE && count == 1))
+    {
+        printf("Line %d: usage: %s\n", lineNumber, commands[command].usage);
+        return;
+    }
+
+    int numbers[2] = {0, 0};
+    for (int i = 0; i < commands[command].numbers; i++)
+    {
+        const char *word = words[count - commands[command].numbers + i];
+        if (!parseIntSlice(word, strlen(word), &numbers[i]))
+        {
+            printf("Line %d: usage: %s\n", lineNumber, commands[command].usage);
+            return;
+        }
+    }
+
+    OwnerNode *owner = NULL;
+    if (commands[command].needsOwner)
+    {
+        owner = findOwnerByName(words[1]);
+        if (owner == NULL)
+        {
+            printf("Line %d: no owner named '%s'.\n", lineNumber, words[1]);
+            return;
+        }
+    }
+
+    switch (command)
+    {
+    case CMD_NEW:
+        switch (applyNewOwner(words[1], numbers[0]))
+        {
+        case OP_OK:
+            printf("New Pokedex created for %s with starter %s.\n", words[1], pokedex[(numbers[0] - 1) * 3].name);
+            break;
+        case OP_ALREADY_OWNED:
+            printf("Owner '%s' already exists. Not creating a new Pokedex.\n", words[1]);
+            break;
+        case OP_NO_MEMORY:
+            break;
+        default:
+            printf("Line %d: usage: %s\n", lineNumber, commands[command].usage);
+        }
+        break;
+    case CMD_ADD:
+        addPokemonByID(owner, numbers[0]);
+        break;
+    case CMD_RELEASE:
+        releasePokemonByID(owner, numbers[0]);
+        break;
+    case CMD_EVOLVE:
+        evolvePokemonByID(owner, numbers[0]);
+        break;
+    case CMD_FIGHT:
+        fightPokemonByID(owner, numbers[0], numbers[1]);
+        break;
+    case CMD_TOURNAMENT:
+        pokemonTournament(owner);
+        break;
+    case CMD_LEAGUE:
+        runLeague();
+        break;
+    case CMD_EVOLVE_ALL:
+        if (strcmp(words[2], "once") == 0)
+            evolveAllByOwner(owner, 0);
+        else if (strcmp(words[2], "final") == 0)
+            evolveAllByOwner(owner, 1);
+        else
+            printf("Line %d: usage: %s\n", lineNumber, commands[command].usage);
+        break;
+    case CMD_ADD_MANY:
+    {
+        uint32_t ids[OWNED_WORDS];
+        if (parseIdRanges(words[2], ids))
+            addManyByOwner(owner, ids);
+        else
+            printf("Line %d: usage: %s\n", lineNumber, commands[command].usage);
+        break;
+    }
+    case CMD_RELEASE_WHERE:
+    {
+        ReleasePredicate predicate;
+        if (parseReleasePredicate(words[2], &predicate))
+            releaseWhereByOwner(owner, &predicate);
+        else
+            printf("Line %d: usage: %s\n", lineNumber, commands[command].usage);
+        break;
+    }
+    case CMD_DISPLAY:
+    {
+        static const char *orders[] = {"bfs", "pre", "in", "post", "alpha"};
+        int order = 0;
+        while (order < 5 && strcmp(words[2], orders[order]) != 0)
+            order++;
+        if (order == 5)
+            printf("Line %d: usage: %s\n", lineNumber, commands[command].usage);
+        else if (owner->pokedexRoot == NULL)
+            printf("Pokedex is empty.\n");
+        else
+            displayPokedexOrder(owner, order + 1);
+        break;
+    }
+    case CMD_DELETE:
+        printf("Deleting %s's entire Pokedex...\n", owner->ownerName);
+        applyDeleteOwner(owner);
+        printf("Pokedex deleted.\n");
+        break;
+    case CMD_MERGE:
+    {
+        OwnerNode *second = findOwnerByName(words[2]);
+        if (second == NULL)
+            printf("Line %d: no owner named '%s'.\n", lineNumber, words[2]);
+        else if (second == owner)
+            printf("Line %d: cannot merge an owner with itself.\n", lineNumber);
+        else
+        {
+            applyMergeOwners(owner, second);
+            printf("Merged '%s' into '%s'.\n", words[2], words[1]);
+        }
+        break;
+    }
+    case CMD_SORT:
+        sortOwners();
+        break;
+    case CMD_SAVE:
+    {
+        const char *path = count == 2 ? words[1] : snapshotPath;
+        if (path == NULL)
+            printf("Line %d: usage: save <file> (no --snapshot file given)\n", lineNumber);
+        else if (saveSnapshot(path))
+            printf("Snapshot saved to %s.\n", path);
+        else
+            printf("Could not save snapshot to %s.\n", path);
+        break;
+    }
+#ifdef POKEDEX_STATS
+    case CMD_STATS:
+        printOpStats(stdout);
+        break;
+#endif
+    case CMD_PRINT:
+        if (strcmp(words[1], "F") != 0 && strcmp(words[1], "B") != 0)
+            printf("Line %d: usage: %s\n", lineNumber, commands[command].usage);
+        else
+            printOwnersSteps(words[1][0], numbers[0]);
+        break;
+    }
+}
+
+#ifdef POKEDEX_STATS
+/* ------------------------------------------------------------
+   15) Operation Stats
+   ------------------------------------------------------------ */
+
+void printOpStats(FILE *out)
+{
+    fprintf(out, "%-12s %9s %12s %12s %10s %10s %9s %7s %6s\n", "command", "calls", "visits",
+            "compares", "allocs", "frees", "mallocs", "height", "depth");
+    for (int op = 0; op < STAT_OP_COUNT; op++)
+    {
+        const OpStats *stats = &opStats[op];
+        fprintf(out, "%-12s %9ld %12ld %12ld %10ld %10ld %9ld %7d %6d\n", statOpNames[op], stats->calls,
+                stats->nodeVisits, stats->comparisons, stats->nodeAllocs, stats->nodeFrees, stats->mallocs,
+                stats->maxHeight, stats->maxDepth);
+    }
+}
+#endif
+
+/* ------------------------------------------------------------
+   16) Snapshots
+   ------------------------------------------------------------ */
+
+void writeU32(FILE *file, uint32_t value)
+{
+    unsigned char bytes[4] = {(unsigned char)value, (unsigned char)(value >> 8),
+                              (unsigned char)(value >> 16), (unsigned char)(value >> 24)};
+    fwrite(bytes, 1, 4, file);
+}
+
+int readU32(const unsigned char **cursor, const unsigned char *end, uint32_t *value)
+{
+    if (end - *cursor < 4)
+        return 0;
+    const unsigned char *bytes = *cursor;
+    *value = (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+    *cursor += 4;
+    return 1;
+}
+
+int saveSnapshot(const char *path)
+{
+    size_t pathLength = strlen(path);
+    char *tempPath = (char *)malloc(pathLength + 5);
+    STAT_COUNT(mallocs, 1);
+    if (tempPath == NULL)
+        return 0;
+    memcpy(tempPath, path, pathLength);
+    memcpy(tempPath + pathLength, ".tmp", 5);
+
+    FILE *file = fopen(tempPath, "wb");
+    if (file == NULL)
+    {
+        free(tempPath);
+        return 0;
+    }
+    uint32_t generation = snapshotGeneration + 1;
+    fwrite(SNAPSHOT_MAGIC, 1, 4, file);
+    fputc(SNAPSHOT_VERSION, file);
+    writeU32(file, generation);
+    writeU32(file, (uint32_t)ownersAmount());
+    if (ownerHead != NULL)
+    {
+        PokemonNode *nodes[MAX_POKEMON_ID];
+        unsigned char ids[MAX_POKEMON_ID];
+        OwnerNode *owner = ownerHead;
+        do
+        {
+            size_t nameLength = strlen(owner->ownerName);
+            writeU32(file, (uint32_t)nameLength);
+            fwrite(owner->ownerName, 1, nameLength, file);
+            int count = flattenPokedex(owner->pokedexRoot, nodes);
+            for (int i = 0; i < count; i++)
+                ids[i] = (unsigned char)nodes[i]->data->id;
+            fputc(count, file);
+            fwrite(ids, 1, count, file);
+            owner = owner->next;
+        } while (owner != ownerHead);
+    }
+    // only replace the old snapshot once the new one is completely written
+    int ok = !ferror(file);
+    ok &= fclose(file) == 0;
+    ok = ok && rename(tempPath, path) == 0;
+    if (!ok)
+        remove(tempPath);
+    free(tempPath);
+
+    // the snapshot now holds everything the journal did; a crash before the journal
+    // is reset is fine too, a journal from an older generation is ignored on startup
+    if (ok && snapshotPath != NULL && strcmp(path, snapshotPath) == 0)
+    {
+        snapshotGeneration = generation;
+        if (journalFd >= 0 && !resetJournal(generation))
+            fprintf(stderr, "Could not reset the journal.\n");
+    }
+    return ok;
+}
+
+OwnerNode *restoreOwner(char *ownerName, const unsigned char *ids, int count)
+{
+    OwnerNode *owner = createOwner(ownerName, NULL);
+    if (owner == NULL)
+        return NULL;
+    PokemonNode *nodes[MAX_POKEMON_ID];
+    for (int i = 0; i < count; i++)
+    {
+        nodes[i] = createPokemonNode(&owner->arena, &pokedex[ids[i] - 1]);
+        if (nodes[i] == NULL)
+        {
+            // the caller still owns the name when we fail
+            owner->ownerName = NULL;
+            freeOwnerNode(owner);
+            return NULL;
+        }
+        markPokemonOwned(owner, ids[i]);
+    }
+    owner->pokedexRoot = buildBalancedTree(nodes, count);
+    return owner;
+}
+
+long loadSnapshot(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+        return errno == ENOENT ? 0 : -1;
+    // read the whole file at once, then parse it in memory
+    long size = -1;
+    if (fseek(file, 0, SEEK_END) == 0)
+        size = ftell(file);
+    unsigned char *data = size >= 0 ? (unsigned char *)malloc(size > 0 ? size : 1) : NULL;
+    STAT_COUNT(mallocs, size >= 0);
+    int readOk = data != NULL && fseek(file, 0, SEEK_SET) == 0 && fread(data, 1, size, file) == (size_t)size;
+    fclose(file);
+    if (!readOk)
+    {
+        free(data);
+        return -1;
+    }
+
+    const unsigned char *cursor = data;
+    const unsigned char *end = data + size;
+    uint32_t ownerCount = 0;
+    long loaded = 0;
+    int version = size >= 5 ? cursor[4] : 0;
+    int ok = size >= 5 && memcmp(cursor, SNAPSHOT_MAGIC, 4) == 0 && (version == 1 || version == SNAPSHOT_VERSION);
+    cursor += 5;
+    uint32_t generation = 0;
+    if (ok && version >= 2)
+        ok = readU32(&cursor, end, &generation);
+    ok = ok && readU32(&cursor, end, &ownerCount);
+    for (uint32_t n = 0; ok && n < ownerCount; n++)
+    {
+        uint32_t nameLength;
+        // the name and its count byte must both fit; comparing without adding 1 to nameLength
+        // keeps a corrupt 0xFFFFFFFF length from wrapping (and from wrapping malloc below)
+        if (!readU32(&cursor, end, &nameLength) || (size_t)nameLength >= (size_t)(end - cursor))
+        {
+            ok = 0;
+            break;
+        }
+        const unsigned char *name = cursor;
+        cursor += nameLength;
+        int count = *cursor++;
+        if (count > MAX_POKEMON_ID || end - cursor < count)
+        {
+            ok = 0;
+            break;
+        }
+        // IDs must be valid and strictly ascending, or the rebuilt tree wouldn't be a BST
+        for (int i = 0; ok && i < count; i++)
+            ok = cursor[i] >= 1 && cursor[i] <= MAX_POKEMON_ID && (i == 0 || cursor[i] > cursor[i - 1]);
+        char *ownerName = (char *)malloc(nameLength + 1);
+        STAT_COUNT(mallocs, 1);
+        if (!ok || ownerName == NULL)
+        {
+            free(ownerName);
+            ok = 0;
+            break;
+        }
+        memcpy(ownerName, name, nameLength);
+        ownerName[nameLength] = '\0';
+        if (findOwnerByName(ownerName) != NULL)
+        {
+            free(ownerName);
+            ok = 0;
+            break;
+        }
+        OwnerNode *owner = restoreOwner(ownerName, cursor, count);
+        if (owner == NULL)
+        {
+            free(ownerName);
+            ok = 0;
+            break;
+        }
+        if (!linkOwnerInCircularList(owner))
+        {
+            freeOwnerNode(owner);
+            ok = 0;
+            break;
+        }
+        cursor += count;
+        loaded++;
+    }
+    free(data);
+    if (!ok || cursor != end)
+        return -1;
+    snapshotGeneration = generation;
+    return loaded;
+}
+
+void saveSnapshotMenu()
+{
+    if (snapshotPath != NULL)
+    {
+        if (saveSnapshot(snapshotPath))
+            printf("Snapshot saved to %s.\n", snapshotPath);
+        else
+            printf("Could not save snapshot to %s.\n", snapshotPath);
+        return;
+    }
+    printf("Snapshot file: ");
+    char *path = getDynamicInput();
+    if (path == NULL)
+        return;
+    if (path[0] != '\0' && saveSnapshot(path))
+        printf("Snapshot saved to %s.\n", path);
+    else
+        printf("Could not save snapshot to %s.\n", path);
+    free(path);
+}
+
+/* ------------------------------------------------------------
+   17) Operation Journal
+   ------------------------------------------------------------ */
+
+long journalClock(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000L + now.tv_nsec;
+}
+
+int writeAll(int fd, const char *data, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t written = write(fd, data, len);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            return 0;
+        data += written;
+        len -= (size_t)written;
+    }
+    return 1;
+}
+
+void journalAppend(const void *data, size_t len)
+{
+    if (journalUsed + len > JOURNAL_BUFFER_SIZE)
+    {
+        journalCommit();
+        // bigger than the whole buffer (a huge name): straight to the file
+        if (len > JOURNAL_BUFFER_SIZE)
+        {
+            if (!writeAll(journalFd, data, len))
+                fprintf(stderr, "Could not write the journal.\n");
+            return;
+        }
+    }
+    memcpy(journalBuffer + journalUsed, data, len);
+    journalUsed += len;
+}
+
+void journalAppendName(const char *name)
+{
+    uint32_t len = (uint32_t)strlen(name);
+    unsigned char bytes[4] = {(unsigned char)len, (unsigned char)(len >> 8),
+                              (unsigned char)(len >> 16), (unsigned char)(len >> 24)};
+    journalAppend(bytes, 4);
+    journalAppend(name, len);
+}
+
+void journalRecord(char op, const char *name, const char *otherName, int value)
+{
+    if (journalFd < 0 || journalReplaying)
+        return;
+    journalAppend(&op, 1);
+    if (name != NULL)
+        journalAppendName(name);
+    if (otherName != NULL)
+        journalAppendName(otherName);
+    if (op == 'N' || op == 'A' || op == 'R' || op == 'E' || op == 'V')
+    {
+        unsigned char byte = (unsigned char)value;
+        journalAppend(&byte, 1);
+    }
+    journalCommitIfDue();
+}
+
+void journalRecordIds(char op, const char *name, const uint32_t *ids)
+{
+    if (journalFd < 0 || journalReplaying)
+        return;
+    journalAppend(&op, 1);
+    journalAppendName(name);
+    for (int w = 0; w < OWNED_WORDS; w++)
+    {
+        unsigned char bytes[4] = {(unsigned char)ids[w], (unsigned char)(ids[w] >> 8),
+                                  (unsigned char)(ids[w] >> 16), (unsigned char)(ids[w] >> 24)};
+        journalAppend(bytes, 4);
+    }
+    journalCommitIfDue();
+}
+
+void journalCommitIfDue()
+{
+    if (journalUsed >= JOURNAL_COMMIT_BYTES || journalClock() - journalLastCommit >= JOURNAL_COMMIT_NANOS)
+        journalCommit();
+}
+
+void journalCommit()
+{
+    if (journalFd < 0)
+    {
+        journalUsed = 0;
+        return;
+    }
+    journalLastCommit = journalClock();
+    if (journalUsed == 0)
+        return;
+    if (!writeAll(journalFd, journalBuffer, journalUsed) || fsync(journalFd) != 0)
+        fprintf(stderr, "Could not write the journal.\n");
+    journalUsed = 0;
+}
+
+int resetJournal(uint32_t generation)
+{
+    journalUsed = 0;
+    char header[9];
+    memcpy(header, JOURNAL_MAGIC, 4);
+    header[4] = JOURNAL_VERSION;
+    for (int i = 0; i < 4; i++)
+        header[5 + i] = (char)(generation >> (8 * i));
+    return ftruncate(journalFd, 0) == 0 && lseek(journalFd, 0, SEEK_SET) == 0 &&
+           writeAll(journalFd, header, sizeof(header)) && fsync(journalFd) == 0;
+}
+
+void closeJournal()
+{
+    journalCommit();
+    if (journalFd >= 0)
+        close(journalFd);
+    journalFd = -1;
+    free(journalPath);
+    journalPath = NULL;
+}
+
+int journalReadName(const unsigned char **cursor, const unsigned char *end, char **scratch, size_t *scratchSize)
+{
+    uint32_t len;
+    if (!readU32(cursor, end, &len) || (uint32_t)(end - *cursor) < len)
+        return 0;
+    if (len + 1 > *scratchSize)
+    {
+        char *bigger = (char *)realloc(*scratch, len + 1);
+        STAT_COUNT(mallocs, 1);
+        if (bigger == NULL)
+            return 0;
+        *scratch = bigger;
+        *scratchSize = len + 1;
+    }
+    memcpy(*scratch, *cursor, len);
+    (*scratch)[len] = '\0';
+    *cursor += len;
+    return 1;
+}
+
+long replayJournalRecords(const unsigned char *data, const unsigned char *end, const unsigned char **goodEnd)
+{
+    char *name = NULL, *otherName = NULL;
+    size_t nameSize = 0, otherSize = 0;
+    const unsigned char *cursor = data;
+    long applied = 0;
+    int valid = 1;
+    *goodEnd = data;
+    while (cursor < end && valid)
+    {
+        char op = (char)*cursor++;
+        int complete = 1;
+        int value = 0;
+        uint32_t ids[OWNED_WORDS];
+        if (op != 'S')
+            complete = journalReadName(&cursor, end, &name, &nameSize);
+        if (complete && op == 'M')
+            complete = journalReadName(&cursor, end, &otherName, &otherSize);
+        if (complete && (op == 'N' || op == 'A' || op == 'R' || op == 'E' || op == 'V'))
+        {
+            complete = cursor < end;
+            if (complete)
+                value = *cursor++;
+        }
+        for (int w = 0; complete && (op == 'B' || op == 'X') && w < OWNED_WORDS; w++)
+            complete = readU32(&cursor, end, &ids[w]);
+        // a record cut off at the end is a commit that never finished
+        if (!complete)
+            break;
+
+        OwnerNode *owner = op == 'N' || op == 'S' ? NULL : findOwnerByName(name);
+        switch (op)
+        {
+        case 'N':
+            valid = applyNewOwner(name, value) == OP_OK;
+            break;
+        case 'A':
+            valid = owner != NULL && applyAddPokemon(owner, value) == OP_OK;
+            break;
+        case 'R':
+            valid = owner != NULL && applyReleasePokemon(owner, value) == OP_OK;
+            break;
+        case 'E':
+            valid = owner != NULL && applyEvolvePokemon(owner, value) == OP_OK;
+            break;
+        case 'V':
+            valid = owner != NULL && applyEvolveAll(owner, value) > 0;
+            break;
+        case 'B':
+            valid = owner != NULL && applyAddMany(owner, ids) > 0;
+            break;
+        case 'X':
+            valid = owner != NULL && applyReleaseMany(owner, ids) > 0;
+            break;
+        case 'D':
+            valid = owner != NULL;
+            if (valid)
+                applyDeleteOwner(owner);
+            break;
+        case 'M':
+        {
+            OwnerNode *second = findOwnerByName(otherName);
+            valid = owner != NULL && second != NULL && owner != second;
+            if (valid)
+                applyMergeOwners(owner, second);
+            break;
+        }
+        case 'S':
+            valid = applySortOwners();
+            break;
+        default:
+            valid = 0;
+        }
+        if (valid)
+        {
+            applied++;
+            *goodEnd = cursor;
+        }
+    }
+    free(name);
+    free(otherName);
+    return valid ? applied : -1;
+}
+
+long openJournal(const char *snapshot)
+{
+    size_t len = strlen(snapshot);
+    journalPath = (char *)malloc(len + sizeof(".journal"));
+    STAT_COUNT(mallocs, 1);
+    if (journalPath == NULL)
+        return -1;
+    memcpy(journalPath, snapshot, len);
+    memcpy(journalPath + len, ".journal", sizeof(".journal"));
+    journalFd = open(journalPath, O_RDWR | O_CREAT, 0644);
+    if (journalFd < 0)
+        return -1;
+
+    // read the whole journal, it's at most one snapshot interval of records
+    off_t size = lseek(journalFd, 0, SEEK_END);
+    unsigned char *data = size >= 0 ? (unsigned char *)malloc(size > 0 ? (size_t)size : 1) : NULL;
+    STAT_COUNT(mallocs, size >= 0);
+    if (data == NULL || lseek(journalFd, 0, SEEK_SET) != 0)
+    {
+        free(data);
+        return -1;
+    }
+    size_t have = 0;
+    while (have < (size_t)size)
+    {
+        ssize_t got = read(journalFd, data + have, (size_t)size - have);
+        if (got < 0 && errno == EINTR)
+            continue;
+        if (got <= 0)
+            break;
+        have += (size_t)got;
+    }
+
+    long applied = 0;
+    off_t keep = 0;
+    uint32_t generation = 0;
+    const unsigned char *cursor = data + 5;
+    char header[5];
+    memcpy(header, JOURNAL_MAGIC, 4);
+    header[4] = JOURNAL_VERSION;
+    // shorter than a header and matching what there is of one: a reset cut off by a crash,
+    // which never held records
+    int tornHeader = have < 9 && memcmp(data, header, have < 5 ? have : 5) == 0;
+    int badHeader = !tornHeader && (have < 9 || memcmp(data, header, 5) != 0);
+    if (have != (size_t)size || badHeader)
+    {
+        free(data);
+        fprintf(stderr, have != (size_t)size ? "Could not read '%s'.\n"
+                                             : "'%s' is not a journal this program can read; move it away to start a new one.\n",
+                journalPath);
+        return -1;
+    }
+    if (!tornHeader)
+        readU32(&cursor, data + have, &generation);
+    // a journal for a newer generation than the snapshot means the snapshot was replaced;
+    // dropping it would throw away committed changes
+    if (!tornHeader && generation > snapshotGeneration)
+    {
+        free(data);
+        fprintf(stderr, "'%s' belongs to a newer snapshot (generation %lu, snapshot has %lu); move it away to start a new one.\n",
+                journalPath, (unsigned long)generation, (unsigned long)snapshotGeneration);
+        return -1;
+    }
+    int ours = !tornHeader && generation == snapshotGeneration;
+    if (ours)
+    {
+        const unsigned char *goodEnd;
+        journalReplaying = 1;
+        applied = replayJournalRecords(data + 9, data + have, &goodEnd);
+        journalReplaying = 0;
+        keep = (off_t)(goodEnd - data);
+    }
+    free(data);
+    if (applied < 0)
+        return -1;
+
+    // missing, empty, cut off while being reset, or left over from an older snapshot
+    // (whose records are all in the snapshot already): start a fresh one
+    if (!ours && !resetJournal(snapshotGeneration))
+        return -1;
+    // drop a record cut off by a crash so new ones follow the last complete one
+    if (ours && keep < size && (ftruncate(journalFd, keep) != 0 || fsync(journalFd) != 0))
+        return -1;
+
+    if (lseek(journalFd, 0, SEEK_END) < 0)
+        return -1;
+    journalLastCommit = journalClock();
+    return applied;
+}
+
+/* ------------------------------------------------------------
+   18) Compact Pokedex Storage
+   ------------------------------------------------------------ */
+
+int buildCompactPokedex(CompactPokedex *out, const uint8_t *ids, int count)
+{
+    out->nodes = NULL;
+    out->count = 0;
+    if (count <= 0)
+        return 1;
+    out->nodes = (CompactNode *)malloc(count * sizeof(CompactNode));
+    STAT_COUNT(mallocs, 1);
+    if (out->nodes == NULL)
+        return 0;
+    out->count = count;
+
+    // ranges of ids still to place; the range queued n-th goes to slot n, so slots
+    // are handed out level by level and a node's children come right after its level
+    int low[MAX_POKEMON_ID], high[MAX_POKEMON_ID];
+    int head = 0, tail = 1;
+    low[0] = 0;
+    high[0] = count;
+    while (head < tail)
+    {
+        int slot = head;
+        int lo = low[head], hi = high[head];
+        head++;
+        int middle = lo + (hi - lo) / 2;
+        CompactNode *node = &out->nodes[slot];
+        node->id = ids[middle];
+        node->left = COMPACT_NONE;
+        node->right = COMPACT_NONE;
+        if (middle > lo)
+        {
+            node->left = (uint8_t)tail;
+            low[tail] = lo;
+            high[tail++] = middle;
+        }
+        if (middle + 1 < hi)
+        {
+            node->right = (uint8_t)tail;
+            low[tail] = middle + 1;
+            high[tail++] = hi;
+        }
+    }
+    return 1;
+}
+
+int compactFromTree(CompactPokedex *out, PokemonNode *root)
+{
+    PokemonNode *nodes[MAX_POKEMON_ID];
+    uint8_t ids[MAX_POKEMON_ID];
+    int count = flattenPokedex(root, nodes);
+    for (int i = 0; i < count; i++)
+        ids[i] = (uint8_t)nodes[i]->data->id;
+    return buildCompactPokedex(out, ids, count);
+}
+
+int compactContains(const CompactPokedex *compact, int id)
+{
+    int index = compact->count > 0 ? 0 : COMPACT_NONE;
+    while (index != COMPACT_NONE)
+    {
+        const CompactNode *node = &compact->nodes[index];
+        if (node->id == id)
+            return 1;
+        index = node->id > id ? node->left : node->right;
+    }
+    return 0;
+}
+
+int compactIds(const CompactPokedex *compact, uint8_t *out)
+{
+    uint8_t stack[MAX_TREE_HEIGHT];
+    int top = 0;
+    int count = 0;
+    int index = compact->count > 0 ? 0 : COMPACT_NONE;
+    while (index != COMPACT_NONE || top > 0)
+    {
+        while (index != COMPACT_NONE)
+        {
+            stack[top++] = (uint8_t)index;
+            index = compact->nodes[index].left;
+        }
+        index = stack[--top];
+        out[count++] = compact->nodes[index].id;
+        index = compact->nodes[index].right;
+    }
+    return count;
+}
+
+PokemonNode *compactToTree(const CompactPokedex *compact, PokemonArena *arena)
+{
+    uint8_t ids[MAX_POKEMON_ID];
+    PokemonNode *nodes[MAX_POKEMON_ID];
+    int count = compactIds(compact, ids);
+    for (int i = 0; i < count; i++)
+    {
+        nodes[i] = createPokemonNode(arena, &pokedex[ids[i] - 1]);
+        if (nodes[i] == NULL)
+            return NULL;
+    }
+    return buildBalancedTree(nodes, count);
+}
+
+void freeCompactPokedex(CompactPokedex *compact)
+{
+    free(compact->nodes);
+    compact->nodes = NULL;
+    compact->count = 0;
+}
+
+/* ------------------------------------------------------------
+   19) Tournaments
+   ------------------------------------------------------------ */
+
+void scoreSpecies(const uint8_t *ids, int count, double *scores)
+{
+    int i = 0;
+#if defined(__AVX2__)
+    const __m256d attackWeight = _mm256_set1_pd(1.5);
+    const __m256d hpWeight = _mm256_set1_pd(1.2);
+    for (; i + 8 <= count; i += 8)
+    {
+        // widen 8 byte IDs to 32-bit lanes and gather their stats straight from the columns
+        __m256i lanes = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(ids + i)));
+        __m256i attack = _mm256_i32gather_epi32((const int *)speciesTable.attack, lanes, 4);
+        __m256i hp = _mm256_i32gather_epi32((const int *)speciesTable.hp, lanes, 4);
+        __m256d low = _mm256_add_pd(_mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(attack)), attackWeight),
+                                    _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(hp)), hpWeight));
+        __m256d high = _mm256_add_pd(_mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(attack, 1)), attackWeight),
+                                     _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(hp, 1)), hpWeight));
+        _mm256_storeu_pd(scores + i, low);
+        _mm256_storeu_pd(scores + i + 4, high);
+    }
+#elif defined(__SSE2__)
+    const __m128d attackWeight = _mm_set1_pd(1.5);
+    const __m128d hpWeight = _mm_set1_pd(1.2);
+    for (; i + 4 <= count; i += 4)
+    {
+        // SSE2 has no gather, so the 4 IDs' stats are loaded one by one
+        __m128i attack = _mm_set_epi32(speciesTable.attack[ids[i + 3]], speciesTable.attack[ids[i + 2]],
+                                       speciesTable.attack[ids[i + 1]], speciesTable.attack[ids[i]]);
+        __m128i hp = _mm_set_epi32(speciesTable.hp[ids[i + 3]], speciesTable.hp[ids[i + 2]],
+                                   speciesTable.hp[ids[i + 1]], speciesTable.hp[ids[i]]);
+        __m128d low = _mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(attack), attackWeight),
+                                 _mm_mul_pd(_mm_cvtepi32_pd(hp), hpWeight));
+        __m128d high = _mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(attack, 8)), attackWeight),
+                                  _mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(hp, 8)), hpWeight));
+        _mm_storeu_pd(scores + i, low);
+        _mm_storeu_pd(scores + i + 2, high);
+    }
+#endif
+    for (; i < count; i++)
+        scores[i] = speciesScore(ids[i]);
+}
+
+int compareTournamentEntries(const void *a, const void *b)
+{
+    const TournamentEntry *entryA = (const TournamentEntry *)a;
+    const TournamentEntry *entryB = (const TournamentEntry *)b;
+    if (entryA->score != entryB->score)
+        return entryA->score < entryB->score ? 1 : -1;
+    return entryA->id - entryB->id;
+}
+
+void pokemonTournament(OwnerNode *owner)
+{
+    if (owner == NULL)
+        return;
+    uint8_t ids[MAX_POKEMON_ID];
+    double scores[MAX_POKEMON_ID];
+    TournamentEntry entries[MAX_POKEMON_ID];
+    int count = ownedIdList(owner, ids);
+    if (count == 0)
+    {
+        printf("Pokedex is empty.\n");
+        return;
+    }
+    scoreSpecies(ids, count, scores);
+    for (int i = 0; i < count; i++)
+    {
+        entries[i].score = scores[i];
+        entries[i].id = ids[i];
+    }
+    qsort(entries, count, sizeof(entries[0]), compareTournamentEntries);
+
+    char line[96];
+    OUT_LITERAL("Tournament for ");
+    outString(owner->ownerName, strlen(owner->ownerName));
+    int length = snprintf(line, sizeof(line), ": %d Pokemon, %d fights.\n", count, count * (count - 1) / 2);
+    outString(line, (size_t)length);
+    // entries with equal scores share a rank and draw against each other;
+    // everything after the tie group scored lower, so those are the wins
+    int groupStart = 0;
+    while (groupStart < count)
+    {
+        int groupEnd = groupStart + 1;
+        while (groupEnd < count && entries[groupEnd].score == entries[groupStart].score)
+            groupEnd++;
+        for (int i = groupStart; i < groupEnd; i++)
+        {
+            const PokemonData *species = &pokedex[entries[i].id - 1];
+            length = snprintf(line, sizeof(line), "%d. %s (ID %d) Score = %.2f, Wins = %d, Draws = %d\n",
+                              groupStart + 1, species->name, species->id, entries[i].score,
+                              count - groupEnd, groupEnd - groupStart - 1);
+            outString(line, (size_t)length);
+        }
+        groupStart = groupEnd;
+    }
+    outFlush();
+}
+
+/* ------------------------------------------------------------
+   20) League
+   ------------------------------------------------------------ */
+
+double teamStrength(const OwnerNode *owner)
+{
+    uint8_t ids[MAX_POKEMON_ID];
+    double scores[MAX_POKEMON_ID];
+    double team[LEAGUE_TEAM_SIZE];
+    int teamSize = 0;
+    int count = ownedIdList(owner, ids);
+    scoreSpecies(ids, count, scores);
+    // keep the best scores seen so far, highest first
+    for (int i = 0; i < count; i++)
+    {
+        if (teamSize == LEAGUE_TEAM_SIZE && scores[i] <= team[teamSize - 1])
+            continue;
+        int slot = teamSize < LEAGUE_TEAM_SIZE ? teamSize++ : teamSize - 1;
+        while (slot > 0 && team[slot - 1] < scores[i])
+        {
+            team[slot] = team[slot - 1];
+            slot--;
+        }
+        team[slot] = scores[i];
+    }
+    // every score is a whole number of tenths; adding them up as tenths keeps equal teams exactly equal
+    long tenths = 0;
+    for (int i = 0; i < teamSize; i++)
+        tenths += (long)(team[i] * 10 + 0.5);
+    return tenths / 10.0;
+}
+
+int compareLeagueEntries(const void *a, const void *b)
+{
+    const LeagueEntry *entryA = (const LeagueEntry *)a;
+    const LeagueEntry *entryB = (const LeagueEntry *)b;
+    if (entryA->strength != entryB->strength)
+        return entryA->strength < entryB->strength ? 1 : -1;
+    return strcmp(entryA->owner->ownerName, entryB->owner->ownerName);
+}
+
+void *leagueWorker(void *arg)
+{
+    LeagueWorker *worker = (LeagueWorker *)arg;
+    for (int i = worker->start; i < worker->end; i++)
+        worker->entries[i].strength = teamStrength(worker->entries[i].owner);
+    qsort(worker->entries + worker->start, worker->end - worker->start, sizeof(LeagueEntry), compareLeagueEntries);
+    return NULL;
+}
+
+int leagueThreadCount(int count)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threadCount = count / LEAGUE_OWNERS_PER_THREAD;
+    if (threadCount > cpus)
+        threadCount = (int)cpus;
+    if (threadCount > LEAGUE_MAX_THREADS)
+        threadCount = LEAGUE_MAX_THREADS;
+    if (threadCount < 1)
+        threadCount = 1;
+    return threadCount;
+}
+
+void rankLeague(LeagueEntry *entries, LeagueEntry *standings, int count, int threadCount)
+{
+    // callers may ask for any number of threads; every share needs at least one owner
+    if (threadCount > LEAGUE_MAX_THREADS)
+        threadCount = LEAGUE_MAX_THREADS;
+    if (threadCount > count)
+        threadCount = count;
+    if (threadCount < 1)
+        threadCount = 1;
+    LeagueWorker workers[LEAGUE_MAX_THREADS];
+    pthread_t threads[LEAGUE_MAX_THREADS];
+    int started[LEAGUE_MAX_THREADS];
+    for (int t = 0; t < threadCount; t++)
+    {
+        workers[t].entries = entries;
+        workers[t].start = (int)((long long)count * t / threadCount);
+        workers[t].end = (int)((long long)count * (t + 1) / threadCount);
+        // the last share runs here, and so does any share whose thread couldn't start
+        started[t] = t + 1 < threadCount && pthread_create(&threads[t], NULL, leagueWorker, &workers[t]) == 0;
+    }
+    for (int t = 0; t < threadCount; t++)
+    {
+        if (!started[t])
+            leagueWorker(&workers[t]);
+    }
+    for (int t = 0; t < threadCount; t++)
+    {
+        if (started[t])
+            pthread_join(threads[t], NULL);
+    }
+
+    // merge the sorted shares, taking the best head each time
+    int cursor[LEAGUE_MAX_THREADS];
+    for (int t = 0; t < threadCount; t++)
+        cursor[t] = workers[t].start;
+    for (int i = 0; i < count; i++)
+    {
+        int best = -1;
+        for (int t = 0; t < threadCount; t++)
+        {
+            if (cursor[t] < workers[t].end &&
+                (best < 0 || compareLeagueEntries(&entries[cursor[t]], &entries[cursor[best]]) < 0))
+                best = t;
+        }
+        standings[i] = entries[cursor[best]++];
+    }
+}
+
+void runLeague()
+{
+    int count = ownersAmount();
+    if (count == 0)
+    {
+        printf("No existing Pokedexes.\n");
+        return;
+    }
+    LeagueEntry *entries = (LeagueEntry *)malloc(count * sizeof(LeagueEntry));
+    LeagueEntry *standings = (LeagueEntry *)malloc(count * sizeof(LeagueEntry));
+    STAT_COUNT(mallocs, 2);
+    if (entries == NULL || standings == NULL)
+    {
+        free(entries);
+        free(standings);
+        printf("Memory allocation failed.\n");
+        return;
+    }
+    // the threads work on this array, never on the ring itself
+    OwnerNode *owner = ownerHead;
+    for (int i = 0; i < count; i++, owner = owner->next)
+        entries[i].owner = owner;
+
+    rankLeague(entries, standings, count, leagueThreadCount(count));
+
+    char line[96];
+    int length = snprintf(line, sizeof(line), "League: %d owners, %lld matches.\n",
+                          count, (long long)count * (count - 1) / 2);
+    outString(line, (size_t)length);
+    // same ranking as a tournament: ties share a rank and draw, everyone below is a win
+    int groupStart = 0;
+    while (groupStart < count)
+    {
+        int groupEnd = groupStart + 1;
+        while (groupEnd < count && standings[groupEnd].strength == standings[groupStart].strength)
+            groupEnd++;
+        for (int i = groupStart; i < groupEnd; i++)
+        {
+            outInt(groupStart + 1);
+            OUT_LITERAL(". ");
+            outString(standings[i].owner->ownerName, strlen(standings[i].owner->ownerName));
+            length = snprintf(line, sizeof(line), " Strength = %.2f, Wins = %d, Draws = %d\n",
+                              standings[i].strength, count - groupEnd, groupEnd - groupStart - 1);
+            outString(line, (size_t)length);
+        }
+        groupStart = groupEnd;
+    }
+    outFlush();
+    free(entries);
+    free(standings);
+}
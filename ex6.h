@@ -1,6 +1,13 @@
 #ifndef EX6_H
 #define EX6_H
 #include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// highest species ID in the pokedex[] table below
+#define MAX_POKEMON_ID 151
+// 32-bit words needed for one bit per species ID (bit 0 unused)
+#define OWNED_WORDS (MAX_POKEMON_ID / 32 + 1)
 
 
 
@@ -29,6 +36,69 @@ typedef enum
     CAN_EVOLVE
 } EvolutionStatus;
 
+// what an apply* operation did; the menus and batch mode turn it into a message
+typedef enum
+{
+    OP_OK,
+    OP_INVALID_ID,
+    OP_ALREADY_OWNED,
+    OP_NOT_FOUND,
+    OP_CANNOT_EVOLVE,
+    OP_NO_MEMORY       // an allocation failed (already reported when it happened)
+} OpResult;
+
+// which Pokemon a bulk release lets go
+typedef enum
+{
+    RELEASE_TYPE,          // type equals low (a PokemonType)
+    RELEASE_HP_BELOW,      // hp < low
+    RELEASE_ATTACK_RANGE,  // low <= attack <= high
+    RELEASE_CAN_EVOLVE,
+    RELEASE_CANNOT_EVOLVE
+} ReleaseRule;
+
+typedef struct ReleasePredicate
+{
+    ReleaseRule rule;
+    int low;
+    int high;
+} ReleasePredicate;
+
+#ifdef POKEDEX_STATS
+// commands the counters are charged to (STAT_OP_OTHER is anything before the first one)
+typedef enum
+{
+    STAT_OP_OTHER,
+    STAT_OP_NEW,
+    STAT_OP_ADD,
+    STAT_OP_RELEASE,
+    STAT_OP_EVOLVE,
+    STAT_OP_FIGHT,
+    STAT_OP_DISPLAY,
+    STAT_OP_DELETE,
+    STAT_OP_MERGE,
+    STAT_OP_SORT,
+    STAT_OP_PRINT,
+    STAT_OP_EVOLVE_ALL,
+    STAT_OP_ADD_MANY,
+    STAT_OP_RELEASE_MANY,
+    STAT_OP_COUNT
+} StatOp;
+
+// what one kind of command has cost so far
+typedef struct OpStats
+{
+    long calls;
+    long nodeVisits;   // tree nodes touched (searches, inserts, removes, traversals, rebuilds)
+    long comparisons;  // ID and owner-name comparisons
+    long nodeAllocs;   // nodes handed out by an arena
+    long nodeFrees;    // nodes given back to an arena
+    long mallocs;      // every malloc/calloc/realloc call
+    int maxHeight;     // tallest pokedex left behind
+    int maxDepth;      // deepest traversal stack or longest BFS queue
+} OpStats;
+#endif
+
 typedef struct PokemonData
 {
     int id;
@@ -39,14 +109,52 @@ typedef struct PokemonData
     EvolutionStatus CAN_EVOLVE;
 } PokemonData;
 
+// entries per SpeciesTable column: slot 0 (unused) plus one per ID, rounded up to a multiple of 8
+#define SPECIES_TABLE_SIZE ((MAX_POKEMON_ID + 1 + 7) / 8 * 8)
+
+// columns start on a 32-byte boundary so vector loops can use aligned loads
+#ifdef __GNUC__
+#define SPECIES_ALIGN __attribute__((aligned(32)))
+#else
+#define SPECIES_ALIGN
+#endif
+
+// The numeric fields of pokedex[] split into one array per field, indexed by ID.
+// pokedex[] stays the source of truth; this is a copy made once at startup so bulk
+// stat loops read only the fields they use, 8 IDs per 32 bytes. Slot 0 and the padding are zero.
+typedef struct SpeciesTable
+{
+    int32_t hp[SPECIES_TABLE_SIZE] SPECIES_ALIGN;
+    int32_t attack[SPECIES_TABLE_SIZE] SPECIES_ALIGN;
+    uint8_t type[SPECIES_TABLE_SIZE] SPECIES_ALIGN;      // PokemonType
+    uint8_t canEvolve[SPECIES_TABLE_SIZE] SPECIES_ALIGN; // EvolutionStatus
+} SpeciesTable;
+
 // Binary Tree Node (for Pokédex)
 typedef struct PokemonNode
 {
     const PokemonData *data;
     struct PokemonNode *left;
     struct PokemonNode *right;
+    int height; // AVL height of the subtree rooted here (a leaf is 1)
 } PokemonNode;
 
+// One block of PokemonNodes from a single malloc; an owner's nodes live side by side in its slabs
+typedef struct PokemonSlab
+{
+    struct PokemonSlab *next; // older slab of the same arena
+    int used;                 // nodes handed out from this slab so far
+    int capacity;             // nodes this slab holds
+    PokemonNode nodes[];
+} PokemonSlab;
+
+// Per-owner node allocator: nodes are carved from the owner's slabs, released nodes are reused
+typedef struct PokemonArena
+{
+    PokemonSlab *slabs;    // newest slab first
+    PokemonNode *freeList; // released nodes, chained through their left pointer
+} PokemonArena;
+
 typedef struct NodeArray
 {
     PokemonNode **nodes;
@@ -54,6 +162,15 @@ typedef struct NodeArray
     int capacity;
 } NodeArray;
 
+// FIFO of nodes for level-order (BFS) traversals; the buffer is reused between traversals
+typedef struct PokemonQueue
+{
+    PokemonNode **nodes;
+    int head;     // next node to dequeue
+    int tail;     // next free slot
+    int capacity;
+} PokemonQueue;
+
 // Linked List Node (for Owners)
 typedef struct OwnerNode
 {
@@ -61,22 +178,72 @@ typedef struct OwnerNode
     PokemonNode *pokedexRoot; // Pointer to the root of the owner's Pokédex
     struct OwnerNode *next;   // Next owner in the linked list
     struct OwnerNode *prev;   // Previous owner in the linked list
+    PokemonArena arena;       // where this owner's PokemonNodes are allocated
+    struct OwnerNode *hashNext; // next owner in the same ownerIndex bucket
+    uint32_t ownedIds[OWNED_WORDS]; // one bit per species ID in the Pokédex, kept in sync with pokedexRoot
 } OwnerNode;
 
+// Hash table from owner name to OwnerNode, chained through OwnerNode.hashNext
+typedef struct OwnerIndex
+{
+    OwnerNode **buckets;
+    int bucketCount; // always a power of two
+    int size;        // owners indexed
+} OwnerIndex;
+
+// child index meaning "no child" in a CompactPokedex
+#define COMPACT_NONE 0xFF
+
+// A Pokedex node in 3 bytes: the species ID and its children as indices into the same array
+typedef struct CompactNode
+{
+    uint8_t id;
+    uint8_t left;  // index of the left child, COMPACT_NONE if there is none
+    uint8_t right; // index of the right child, COMPACT_NONE if there is none
+} CompactNode;
+
+// An alternative Pokedex storage: one contiguous array of CompactNodes per owner.
+// An owner has each species at most once, so there are at most MAX_POKEMON_ID nodes
+// and a byte is enough for every index. The tree is balanced and laid out level by level
+// (the root is nodes[0]), so the top levels share the first cache lines.
+typedef struct CompactPokedex
+{
+    CompactNode *nodes;
+    int count;
+} CompactPokedex;
+
+// one Pokemon's place in an owner's tournament
+typedef struct TournamentEntry
+{
+    double score;
+    int id;
+} TournamentEntry;
+
+// one owner's place in the league standings
+typedef struct LeagueEntry
+{
+    double strength; // sum of the fight scores of the owner's best team
+    OwnerNode *owner;
+} LeagueEntry;
+
+// one league thread's share of the owner array: it scores and sorts entries[start, end)
+typedef struct LeagueWorker
+{
+    LeagueEntry *entries;
+    int start;
+    int end;
+} LeagueWorker;
+
 // Global head pointer for the linked list of owners
 OwnerNode *ownerHead = NULL;
 
+// Name index over the same owners as the ring, so name lookups don't walk the list
+OwnerIndex ownerIndex = {NULL, 0, 0};
+
 /* ------------------------------------------------------------
    1) Safe Input + Utility
    ------------------------------------------------------------ */
 
-/**
- * @brief Remove leading/trailing whitespace (including '\r').
- * @param str modifiable string
- * Why we made it: We must handle CR/LF or random spaces in user input.
- */
-void trimWhitespace(char *str);
-
 /**
  * @brief C99-friendly strdup replacement.
  * @param src source string
@@ -85,6 +252,33 @@ void trimWhitespace(char *str);
  */
 char *myStrdup(const char *src);
 
+/**
+ * @brief Hand out the next line of stdin, trimmed, as a slice of the shared input buffer.
+ * @param length set to the trimmed line's length
+ * @return pointer to the line (NUL-terminated, valid until the next call), or NULL at end of input
+ * Why we made it: stdin is read in 64K chunks and lines are cut out in place,
+ * so a long replayed script doesn't cost a getchar/fgets/malloc per line.
+ * Lines longer than the buffer come back in pieces.
+ */
+char *readLine(size_t *length);
+
+/**
+ * @brief Parse a whole slice as a decimal int (optional sign, digits only).
+ * @param str start of the slice
+ * @param length slice length
+ * @param value where the result goes
+ * @return 1 if the slice was a valid int that fits, 0 otherwise
+ */
+int parseIntSlice(const char *str, size_t length, int *value);
+
+/**
+ * @brief Parse a list of IDs and ID ranges, like "1-30,45,100-151", into a set.
+ * @param text the list (spaces around items are fine)
+ * @param ids out: OWNED_WORDS words, one bit per listed ID
+ * @return 1 if every item was an ID or a range of IDs between 1 and MAX_POKEMON_ID, 0 otherwise
+ */
+int parseIdRanges(const char *text, uint32_t *ids);
+
 /**
  * @brief Read an integer safely, re-prompt if invalid.
  * @param prompt text to display
@@ -97,6 +291,7 @@ int readIntSafe(const char *prompt);
  * @brief Read a line from stdin, store in malloc'd buffer, trim whitespace.
  * @return pointer to the newly allocated string (caller frees)
  * Why we made it: We need flexible name input that handles CR/LF etc.
+ * Takes its line from readLine, so the only allocation is the exact-size copy.
  */
 char *getDynamicInput(void);
 
@@ -108,40 +303,82 @@ char *getDynamicInput(void);
  */
 const char *getTypeName(PokemonType type);
 
+/**returns the PokemonType named by name (any letter case), or -1 if there's no such type*/
+int parseTypeName(const char *name);
+
+/**
+ * @brief Parse a bulk release rule: type=FIRE, hp<50, attack=40-60, evolve=yes or evolve=no.
+ * @param text the rule
+ * @param predicate out: the parsed rule
+ * @return 1 if the rule was valid, 0 otherwise
+ */
+int parseReleasePredicate(const char *text, ReleasePredicate *predicate);
+
+/**
+ * @brief Write everything collected in the output buffer to stdout in one block.
+ * Why we made it: Display paths fill the buffer instead of calling printf per line;
+ * they flush when they're done (and input prompts flush first) so the order on screen stays the same.
+ */
+void outFlush(void);
+
+/**appends len bytes to the output buffer, flushing first if they don't fit*/
+void outString(const char *str, size_t len);
+
+/**appends one character to the output buffer*/
+void outChar(char c);
+
+/**appends an int in decimal to the output buffer (formatted by hand, no printf)*/
+void outInt(int value);
+
 /* ------------------------------------------------------------
    2) Creating & Freeing Nodes
    ------------------------------------------------------------ */
 
 /**
  * @brief Create a BST node with a copy of the given PokemonData.
+ * @param arena the owner's arena to allocate the node from
  * @param data pointer to PokemonData (like from the global pokedex)
  * @return newly allocated PokemonNode*
  * Why we made it: We need a standard way to allocate BST nodes.
  */
-PokemonNode *createPokemonNode(const PokemonData *data);
+PokemonNode *createPokemonNode(PokemonArena *arena, const PokemonData *data);
 
 /**
  * @brief Create an OwnerNode for the circular owners list.
  * @param ownerName the dynamically allocated name
- * @param starter BST root for the starter Pokemon
+ * @param starter the starter Pokemon, becomes the BST root
  * @return newly allocated OwnerNode*
  * Why we made it: Each user is represented as an OwnerNode.
  */
-OwnerNode *createOwner(char *ownerName, PokemonNode *starter);
+OwnerNode *createOwner(char *ownerName, const PokemonData *starter);
 
 /**
  * @brief Free one PokemonNode (including name).
+ * @param arena the arena the node was allocated from
  * @param node pointer to node
  * Why we made it: Avoid memory leaks for single nodes.
  */
-void freePokemonNode(PokemonNode *node);
+void freePokemonNode(PokemonArena *arena, PokemonNode *node);
 
 /**
- * @brief Recursively free a BST of PokemonNodes.
+ * @brief Free a BST of PokemonNodes (iterative, explicit stack).
+ * @param arena the arena the nodes were allocated from
  * @param root BST root
- * Why we made it: Clearing a user’s entire Pokedex means freeing a tree.
+ * Why we made it: Clearing part of a Pokedex means freeing a subtree (a whole Pokedex just drops its arena).
  */
-void freePokemonTree(PokemonNode *root);
+void freePokemonTree(PokemonArena *arena, PokemonNode *root);
+
+/**starts an empty arena, no slab is allocated until the first node*/
+void initPokemonArena(PokemonArena *arena);
+
+/**gives back an unused node slot: a released node first, otherwise the next slot of the newest slab (a new slab when it's full)*/
+PokemonNode *allocPokemonNode(PokemonArena *arena);
+
+/**frees every slab of the arena at once, which frees all the nodes allocated from it*/
+void destroyPokemonArena(PokemonArena *arena);
+
+/**moves all the slabs and released nodes of src into dst (src is left empty), so dst's tree can keep src's nodes*/
+void mergePokemonArenas(PokemonArena *dst, PokemonArena *src);
 
 /**
  * @brief Free an OwnerNode (including name and entire Pokedex BST).
@@ -156,12 +393,14 @@ void freeOwnerNode(OwnerNode *owner);
 
 /**
  * @brief Insert a PokemonNode into BST by ID; duplicates freed.
+ * @param arena the owner's arena newNode was allocated from
  * @param root pointer to BST root
- * @param newNode node to insert
- * @return updated BST root
- * Why we made it: Standard BST insertion ignoring duplicates.
+ * @param newNode node to insert, linked into the tree as is (no copy is made)
+ * @return updated BST root (rebalanced, AVL)
+ * Why we made it: Standard BST insertion ignoring duplicates, kept balanced
+ * so adding Pokemon in ascending ID order doesn't turn the tree into a list.
  */
-PokemonNode *insertPokemonNode(PokemonNode *root, PokemonNode *newNode);
+PokemonNode *insertPokemonNode(PokemonArena *arena, PokemonNode *root, PokemonNode *newNode);
 
 /**
  * @brief BFS search for a Pokemon by ID in the BST.
@@ -169,35 +408,76 @@ PokemonNode *insertPokemonNode(PokemonNode *root, PokemonNode *newNode);
  * @param id ID to find
  * @return pointer to found node or NULL
  * Why we made it: BFS ensures we find nodes even in an unbalanced tree.
+ * Uses the same reusable FIFO as BFSGeneric, so it visits each node at most once.
  */
 PokemonNode *searchPokemonBFS(PokemonNode *root, int id);
 
-/**goes over the bst by level by searching for a specific level (distance from the root) to check the pokemon*/
-PokemonNode *searchPokemonByLevel(int id, PokemonNode *root, int level);
+/**
+ * @brief Keyed search for a Pokemon by ID, descending by the BST ordering.
+ * @param root BST root
+ * @param id ID to find
+ * @return pointer to found node or NULL
+ * Why we made it: The tree is ordered by ID, so one root-to-leaf walk (O(log n)) is enough.
+ */
+PokemonNode *searchPokemonBST(PokemonNode *root, int id);
+
+/**returns 1 if the owner has a Pokemon with this ID (a bit test, no tree walk), 0 otherwise*/
+int ownsPokemon(const OwnerNode *owner, int id);
 
-/**returns the maximum height of the tree (the farther distance from a leaf to the root)*/
+/**sets the owner's bit for this ID, call after inserting it into the owner's tree*/
+void markPokemonOwned(OwnerNode *owner, int id);
+
+/**clears the owner's bit for this ID, call after removing it from the owner's tree*/
+void unmarkPokemonOwned(OwnerNode *owner, int id);
+
+/**writes the owner's species IDs into out in ascending order, read from the bitmap (no tree walk), returns how many*/
+int ownedIdList(const OwnerNode *owner, uint8_t *out);
+
+/**returns the maximum height of the tree (the farther distance from a leaf to the root), kept on the root so it's O(1)*/
 int pokedexHeight(PokemonNode *root);
 
+/**recalculates the stored height of a node from the heights of its two children*/
+void updateHeight(PokemonNode *node);
+
+/**rotates the subtree to the right around root and returns the new subtree root*/
+PokemonNode *rotateRight(PokemonNode *root);
+
+/**rotates the subtree to the left around root and returns the new subtree root*/
+PokemonNode *rotateLeft(PokemonNode *root);
+
+/**restores the AVL balance of a subtree after an insert or remove below it, returns the new subtree root*/
+PokemonNode *rebalance(PokemonNode *root);
+
 /**
  * @brief Remove node from BST by ID if found (BST removal logic).
+ * @param arena the owner's arena the removed node goes back to
  * @param root BST root
  * @param id ID to remove
- * @return updated BST root
+ * @param removed set to 1 if a node was removed, untouched otherwise (may be NULL)
+ * @return updated BST root (rebalanced, AVL)
  * Why we made it: We handle special cases of a BST remove (0,1,2 children).
  */
-PokemonNode *removeNodeBST(PokemonNode *root, int id);
+PokemonNode *removeNodeBST(PokemonArena *arena, PokemonNode *root, int id, int *removed);
 
 /**finds a replacement to the pokemon we want to release when that node has 2 children*/
 PokemonNode *findMin(PokemonNode *root);
 
+/**writes the tree's nodes into out sorted by ID (in-order) and returns how many, out needs room for MAX_POKEMON_ID nodes*/
+int flattenPokedex(PokemonNode *root, PokemonNode **out);
+
+/**links nodes already sorted by ID into a balanced BST in O(count), returns the root*/
+PokemonNode *buildBalancedTree(PokemonNode **nodes, int count);
+
 /**
- * @brief Combine BFS search + BST removal to remove Pokemon by ID.
+ * @brief Remove a Pokemon by ID in a single descent (find and remove together).
+ * @param arena the owner's arena the removed node goes back to
  * @param root BST root
  * @param id the ID to remove
+ * @param removed set to 1 if the Pokemon was found and removed, 0 otherwise (may be NULL)
  * @return updated BST root
- * Why we made it: BFS confirms existence, then removeNodeBST does the removal.
+ * Why we made it: Releasing shouldn't search first and then walk the tree again to remove.
  */
-PokemonNode *removePokemonByID(PokemonNode *root, int id);
+PokemonNode *removePokemonByID(PokemonArena *arena, PokemonNode *root, int id, int *removed);
 
 /* ------------------------------------------------------------
    4) Generic BST Traversals (Function Pointers)
@@ -213,17 +493,26 @@ typedef void (*VisitNodeFunc)(PokemonNode *);
  * @param root BST root
  * @param visit function pointer for what to do with each node
  * Why we made it: BFS plus function pointers => flexible traversal.
+ * Single pass over a FIFO whose buffer is reused, so repeated displays don't allocate.
+ * visit() must not start another BFS (they share the buffer).
  */
 void BFSGeneric(PokemonNode *root, VisitNodeFunc visit);
 
-/**goes over the bst by level by searching for a specific level (distance from the root) to print*/
-void genericPokemonByLevel(PokemonNode *root, int level, VisitNodeFunc visit);
+/**adds a node to the back of the queue, growing the buffer if it's full*/
+void enqueuePokemon(PokemonQueue *queue, PokemonNode *node);
+
+/**takes the node at the front of the queue, NULL when the queue is empty*/
+PokemonNode *dequeuePokemon(PokemonQueue *queue);
+
+/**frees the queue buffer (the nodes themselves belong to their tree)*/
+void freePokemonQueue(PokemonQueue *queue);
 
 /**
  * @brief A generic pre-order traversal (Root-Left-Right).
  * @param root BST root
  * @param visit function pointer
  * Why we made it: Another demonstration of function-pointer-based traversal.
+ * Iterative with an explicit stack of at most one node per level, no recursion.
  */
 void preOrderGeneric(PokemonNode *root, VisitNodeFunc visit);
 
@@ -232,6 +521,7 @@ void preOrderGeneric(PokemonNode *root, VisitNodeFunc visit);
  * @param root BST root
  * @param visit function pointer
  * Why we made it: Great for seeing sorted order if BST is sorted by ID.
+ * Iterative with an explicit stack of the current left spine.
  */
 void inOrderGeneric(PokemonNode *root, VisitNodeFunc visit);
 
@@ -240,6 +530,7 @@ void inOrderGeneric(PokemonNode *root, VisitNodeFunc visit);
  * @param root BST root
  * @param visit function pointer
  * Why we made it: Another standard traversal pattern.
+ * Iterative with an explicit stack of the current path.
  */
 void postOrderGeneric(PokemonNode *root, VisitNodeFunc visit);
 
@@ -247,6 +538,7 @@ void postOrderGeneric(PokemonNode *root, VisitNodeFunc visit);
  * @brief Print one PokemonNode’s data: ID, Name, Type, HP, Attack, Evolve?
  * @param node pointer to the node
  * Why we made it: We can pass this to BFSGeneric or others to quickly print.
+ * Goes to the output buffer; whoever runs the traversal calls outFlush() after it.
  */
 void printPokemonNode(PokemonNode *node);
 
@@ -271,7 +563,7 @@ void initNodeArray(NodeArray *na, int cap);
 void addNode(NodeArray *na, PokemonNode *node);
 
 /**
- * @brief Recursively collect all nodes from the BST into a NodeArray.
+ * @brief Collect all nodes from the BST into a NodeArray (pre-order, explicit stack).
  * @param root BST root
  * @param na pointer to NodeArray
  * Why we made it: We gather everything for qsort.
@@ -291,9 +583,26 @@ int compareByNameNode(const void *a, const void *b);
  * @brief BFS is nice, but alphabetical means we gather all nodes, sort by name, then print.
  * @param root BST root
  * Why we made it: Provide user the option to see Pokemon sorted by name.
+ * Sorting is a bucket pass over the precomputed name ranks, O(n), no comparisons.
  */
 void displayAlphabetical(PokemonNode *root);
 
+/**compares two species (const PokemonData**) by name, for sorting the pokedex once in initNameRanks*/
+int compareSpeciesByName(const void *a, const void *b);
+
+/**fills nameRank[] with every species' alphabetical position, called once at startup*/
+void initNameRanks(void);
+
+/**
+ * @brief Fill the species table from pokedex[], called once at startup.
+ * Why we made it: bulk stat work (fight scores, filters, totals) walks plain int/byte
+ * arrays by ID instead of striding over whole PokemonData structs.
+ */
+void initSpeciesTable(void);
+
+/**fight score of a species, attack * 1.5 + hp * 1.2, read from the species table*/
+double speciesScore(int id);
+
 /* ------------------------------------------------------------
    6) Pokemon-Specific
    ------------------------------------------------------------ */
@@ -313,7 +622,7 @@ void pokemonFight(OwnerNode *owner);
 void evolvePokemon(OwnerNode *owner);
 
 /**
- * @brief Prompt for an ID, BFS-check duplicates, then insert into BST.
+ * @brief Prompt for an ID, check duplicates in the owner's bitmap, then insert into BST.
  * @param owner pointer to the Owner
  * Why we made it: Primary user function for adding new Pokemon to an owner’s Pokedex.
  */
@@ -326,6 +635,105 @@ void addPokemon(OwnerNode *owner);
  */
 void freePokemon(OwnerNode *owner);
 
+/**
+ * @brief Add one Pokemon by ID to an owner, without printing anything.
+ * @param owner pointer to the Owner
+ * @param id species ID to add
+ * @return OP_OK, OP_INVALID_ID, OP_ALREADY_OWNED or OP_NO_MEMORY
+ * Why we made it: The menu and batch mode share it, and they print the message themselves.
+ */
+OpResult applyAddPokemon(OwnerNode *owner, int id);
+
+/**removes one Pokemon by ID from an owner without printing; OP_OK or OP_NOT_FOUND*/
+OpResult applyReleasePokemon(OwnerNode *owner, int id);
+
+/**evolves one Pokemon (ID -> ID+1) without printing; OP_OK, OP_NOT_FOUND or OP_CANNOT_EVOLVE*/
+OpResult applyEvolvePokemon(OwnerNode *owner, int id);
+
+/**adds a Pokemon by ID and prints the result, the part of addPokemon after the prompt*/
+void addPokemonByID(OwnerNode *owner, int id);
+
+/**releases a Pokemon by ID and prints the result, the part of freePokemon after the prompt*/
+void releasePokemonByID(OwnerNode *owner, int id);
+
+/**evolves a Pokemon by ID and prints the result, the part of evolvePokemon after the prompt*/
+void evolvePokemonByID(OwnerNode *owner, int id);
+
+/**scores two of the owner's Pokemon and prints the winner, the part of pokemonFight after the prompts*/
+void fightPokemonByID(OwnerNode *owner, int firstId, int secondId);
+
+/**
+ * @brief Evolve every Pokemon of an owner that can evolve, all at once, without printing.
+ * @param owner pointer to the Owner
+ * @param toFinal 0 for one step (ID -> ID+1), 1 to follow the ID+1 chain to the final form
+ * @return how many Pokemon evolved
+ * Why we made it: Evolving a whole Pokedex one ID at a time is a search, a removal and an
+ * insert per Pokemon. Here one in-order pass maps every ID to its evolution (the mapping keeps
+ * the order, so equal results end up next to each other and duplicates are dropped on the spot)
+ * and the tree is rebuilt once, O(n).
+ */
+int applyEvolveAll(OwnerNode *owner, int toFinal);
+
+/**evolves everything the owner has and prints how many evolved*/
+void evolveAllByOwner(OwnerNode *owner, int toFinal);
+
+/**
+ * @brief Ask one step or final form, then evolve the owner's whole Pokedex.
+ * @param owner pointer to the Owner
+ * Why we made it: Seasonal events evolve entire Pokedexes in one go.
+ */
+void evolveAllMenu(OwnerNode *owner);
+
+/**
+ * @brief Add a whole set of species to an owner at once, without printing.
+ * @param owner pointer to the Owner
+ * @param ids OWNED_WORDS words, one bit per ID to add (IDs the owner has are skipped)
+ * @return how many Pokemon were added
+ * Why we made it: Adding one at a time costs a search and an insert per ID. The new IDs come
+ * out of the bitmap already sorted, so they're merged with the in-order nodes in one pass and
+ * the tree is rebuilt balanced once.
+ */
+int applyAddMany(OwnerNode *owner, const uint32_t *ids);
+
+/**adds every ID in the set and prints how many were added and how many were already there*/
+void addManyByOwner(OwnerNode *owner, const uint32_t *ids);
+
+/**
+ * @brief Ask for a list of IDs and ranges, then add them all to the owner.
+ * @param owner pointer to the Owner
+ * Why we made it: Provisioning a trainer with a full set should be one prompt, not 151.
+ */
+void addManyMenu(OwnerNode *owner);
+
+/**
+ * @brief Mark every species that matches a release rule.
+ * @param predicate the rule
+ * @param ids out: OWNED_WORDS words, one bit per matching species ID
+ * Why we made it: Each rule is one tight loop over a single species table column, so matching
+ * doesn't depend on the owner at all and costs the same for every owner.
+ */
+void speciesMatching(const ReleasePredicate *predicate, uint32_t *ids);
+
+/**
+ * @brief Release a whole set of species from an owner at once, without printing.
+ * @param owner pointer to the Owner
+ * @param ids OWNED_WORDS words, one bit per ID to release (IDs the owner doesn't have are skipped)
+ * @return how many Pokemon were released
+ * Why we made it: Releasing one at a time costs a removal (and maybe a successor copy) each.
+ * One in-order walk keeps the survivors, frees the rest and rebuilds the tree balanced, O(n).
+ */
+int applyReleaseMany(OwnerNode *owner, const uint32_t *ids);
+
+/**releases every Pokemon of the owner that matches the rule and prints how many went*/
+void releaseWhereByOwner(OwnerNode *owner, const ReleasePredicate *predicate);
+
+/**
+ * @brief Ask for a release rule (type, hp below, attack range, can/cannot evolve), then apply it.
+ * @param owner pointer to the Owner
+ * Why we made it: Cleanup jobs release everything of a kind, not one ID at a time.
+ */
+void releaseWhereMenu(OwnerNode *owner);
+
 /* ------------------------------------------------------------
    7) Display Menu for a Pokedex
    ------------------------------------------------------------ */
@@ -337,23 +745,39 @@ void freePokemon(OwnerNode *owner);
  */
 void displayMenu(OwnerNode *owner);
 
+/**
+ * @brief Print the whole pokedex in one order and flush it.
+ * @param owner pointer to Owner (its pokedex is not empty)
+ * @param order 1 BFS, 2 pre-order, 3 in-order, 4 post-order, 5 alphabetical
+ * Why we made it: displayMenu and batch mode both end up here.
+ */
+void displayPokedexOrder(OwnerNode *owner, int order);
+
 /* ------------------------------------------------------------
-   8) Sorting Owners (Bubble Sort on Circular List)
+   8) Sorting Owners (Merge Sort on Circular List)
    ------------------------------------------------------------ */
 
 /**
  * @brief Sort the circular owners list by name.
  * Why we made it: Another demonstration of pointer manipulation + sorting logic.
+ * Merge sort that relinks the nodes (O(n log n)), so an OwnerNode* keeps pointing at the same trainer.
  */
 void sortOwners(void);
 
+/**sorts the owner ring by name without printing, returns 0 when there were fewer than 2 owners*/
+int applySortOwners(void);
+
 /**
- * @brief Helper to swap name & pokedexRoot in two OwnerNode.
- * @param a pointer to first owner
- * @param b pointer to second owner
- * Why we made it: Used internally by bubble sort to swap data.
+ * @brief Merge sort a NULL-terminated list of owners (linked by next only) by name.
+ * @param list first owner of the list
+ * @param length how many owners are in the list
+ * @return first owner of the sorted list (prev pointers are not fixed here)
+ * Why we made it: sortOwners opens the ring, sorts it with this, then closes it again.
  */
-void swapOwnerData(OwnerNode *a, OwnerNode *b);
+OwnerNode *mergeSortOwners(OwnerNode *list, int length);
+
+/**merges two name-sorted owner lists (linked by next) into one and returns its first owner*/
+OwnerNode *mergeOwnerLists(OwnerNode *a, OwnerNode *b);
 
 /** returns the amount of owners in the circular linked list for the sort function*/
 int ownersAmount();
@@ -365,9 +789,10 @@ int ownersAmount();
 /**
  * @brief Insert a new owner into the circular list. If none exist, it's alone.
  * @param newOwner pointer to newly created OwnerNode
+ * @return 1 on success, 0 if the owner couldn't be indexed (it is then not linked either; the caller frees it)
  * Why we made it: We need a standard approach to keep the list circular.
  */
-void linkOwnerInCircularList(OwnerNode *newOwner);
+int linkOwnerInCircularList(OwnerNode *newOwner);
 
 /**
  * @brief Remove a specific OwnerNode from the circular list, possibly updating head.
@@ -380,14 +805,33 @@ void removeOwnerFromCircularList(OwnerNode *target);
  * @brief Find an owner by name in the circular list.
  * @param name string to match
  * @return pointer to the matching OwnerNode or NULL
- * Why we made it: We often need to locate an owner quickly.
+ * Why we made it: We often need to locate an owner quickly (hash lookup in ownerIndex, O(1)).
  */
 OwnerNode *findOwnerByName(const char *name);
 
+/**hashes an owner name (FNV-1a) for the ownerIndex buckets*/
+uint32_t hashOwnerName(const char *name);
+
+/**adds the owner to ownerIndex under its current name, doubling the buckets when it gets full
+   (if doubling fails the old buckets just get longer chains); returns 0 only if there are no buckets at all*/
+int indexOwner(OwnerNode *owner);
+
+/**removes the owner from ownerIndex, call before its name changes or it's freed*/
+void unindexOwner(OwnerNode *owner);
+
+/**frees the ownerIndex buckets (the owners themselves are freed with the ring)*/
+void freeOwnerIndex(void);
+
+/**unlinks and frees an owner with its whole Pokedex, without printing*/
+void applyDeleteOwner(OwnerNode *owner);
+
 /* ------------------------------------------------------------
    10) Owner Menus
    ------------------------------------------------------------ */
 
+/**prints the numbered owner list ("1. name") through the output buffer and flushes it*/
+void printOwnerList(void);
+
 /**
  * @brief Let user pick an existing Pokedex (owner) by number, then sub-menu.
  * Why we made it: This is the main interface for adding/fighting/evolving, etc.
@@ -408,12 +852,38 @@ void deletePokedex(void);
 
 /**
  * @brief Merge the second owner's Pokedex into the first, then remove the second owner.
- * Why we made it: BFS copy demonstration plus removing an owner.
+ * Why we made it: Merge demonstration plus removing an owner.
  */
 void mergePokedexMenu(void);
 
-/**goes over the pokedex of the second owner by level by searching for a specific level (distance from the root) to add to the first owner's pokedex*/
-PokemonNode* insertPokemonByLevel(PokemonNode* root, int level, PokemonNode* ownerRoot);
+/**
+ * @brief Move every Pokemon of the second owner into the first owner's Pokedex.
+ * @param first owner that keeps the merged Pokedex
+ * @param second owner whose Pokedex is emptied (its nodes are reused, not copied)
+ * Why we made it: Flatten both trees, merge the two sorted lists dropping duplicate IDs,
+ * and build one balanced tree, all in O(n + m).
+ */
+void mergeOwnerPokedexes(OwnerNode *first, OwnerNode *second);
+
+/**
+ * @brief Create an owner with a starter and link it into the ring, without printing.
+ * @param name owner name (copied; see adoptNewOwner to hand over a heap buffer instead)
+ * @param starter 1 Bulbasaur, 2 Charmander, 3 Squirtle
+ * @return OP_OK, OP_ALREADY_OWNED if the name is taken, OP_INVALID_ID for a bad starter,
+ * OP_NO_MEMORY if the owner couldn't be allocated
+ */
+OpResult applyNewOwner(const char *name, int starter);
+
+/**
+ * @brief Same as applyNewOwner, but takes ownership of a malloc'd name instead of copying it.
+ * @param ownerName heap name; it becomes the owner's name on OP_OK and is freed on any failure
+ * @param starter 1 Bulbasaur, 2 Charmander, 3 Squirtle
+ * @return the same results as applyNewOwner
+ */
+OpResult adoptNewOwner(char *ownerName, int starter);
+
+/**merges the second owner into the first and removes the second from the ring, without printing*/
+void applyMergeOwners(OwnerNode *first, OwnerNode *second);
 
 /* ------------------------------------------------------------
    11) Printing Owners in a Circle
@@ -425,6 +895,9 @@ PokemonNode* insertPokemonByLevel(PokemonNode* root, int level, PokemonNode* own
  */
 void printOwnersCircular(void);
 
+/**prints steps owners starting at the head, going forward for 'F' and backward otherwise*/
+void printOwnersSteps(char direction, int steps);
+
 /* ------------------------------------------------------------
    12) Cleanup All Owners at Program End
    ------------------------------------------------------------ */
@@ -445,6 +918,277 @@ void freeAllOwners(void);
  */
 void mainMenu(void);
 
+/* ------------------------------------------------------------
+   14) Batch Mode
+   ------------------------------------------------------------ */
+
+/**
+ * @brief Run commands from stdin, one per line, with no menus or prompts (./ex6 --batch).
+ * Why we made it: Scripted runs only want the results, not thousands of rendered menus.
+ * Commands (names with spaces go in double quotes, '#' starts a comment line):
+ *   new <owner> <starter 1-3>        delete <owner>
+ *   add <owner> <id>                 merge <first> <second>
+ *   release <owner> <id>             sort
+ *   evolve <owner> <id>              print F|B <count>
+ *   fight <owner> <id> <id>          exit
+ *   tournament <owner>               league
+ *   evolveall <owner> once|final     addmany <owner> <ids>   (ids like 1-30,45,100-151)
+ *   releasewhere <owner> <rule>      (rule: type=FIRE, hp<50, attack=40-60, evolve=yes|no)
+ *   display <owner> bfs|pre|in|post|alpha
+ *   save [file]                      (file defaults to the --snapshot path)
+ *   stats                            (only in -DPOKEDEX_STATS builds)
+ */
+void runBatch(void);
+
+/**
+ * @brief Split a command line into words in place (double quotes group a word).
+ * @param line the line, modified
+ * @param words where the word pointers go
+ * @param maxWords size of words
+ * @return number of words, or -1 for too many words or an unclosed quote
+ */
+int splitCommand(char *line, char **words, int maxWords);
+
+/**runs one split batch command, printing the result or a "Line N:" error*/
+void runBatchCommand(char **words, int count, int lineNumber);
+
+/* ------------------------------------------------------------
+   15) Operation Stats
+   ------------------------------------------------------------ */
+
+#ifdef POKEDEX_STATS
+/**
+ * @brief Print the per-command counters as a table.
+ * @param out where to print (stdout from the menu, stderr at exit)
+ * Why we made it: Shows what each kind of command really costs (only in -DPOKEDEX_STATS builds).
+ */
+void printOpStats(FILE *out);
+#endif
+
+/* ------------------------------------------------------------
+   16) Snapshots
+   ------------------------------------------------------------ */
+
+// Snapshot file layout (integers are little-endian uint32):
+//   "PKDX" 2          magic and format version
+//   generation        bumped on every save, the journal records which one it follows (version 1 had none)
+//   ownerCount
+//   per owner, in ring order:
+//     nameLength, name bytes (no terminator),
+//     pokemonCount (1 byte), pokemonCount species IDs (1 byte each, ascending)
+
+/**writes value to the file as 4 little-endian bytes*/
+void writeU32(FILE *file, uint32_t value);
+
+/**reads 4 little-endian bytes at *cursor (advancing it), returns 0 if fewer than 4 are left before end*/
+int readU32(const unsigned char **cursor, const unsigned char *end, uint32_t *value);
+
+/**
+ * @brief Write every owner and their Pokedex to a snapshot file.
+ * @param path file to write (replaced atomically through path + ".tmp")
+ * @return 1 on success, 0 if the file couldn't be written
+ * Why we made it: All state lives in the ownerHead ring and is lost at exit otherwise.
+ * Saving the --snapshot file also starts a fresh journal, everything in the old one is in the snapshot now.
+ */
+int saveSnapshot(const char *path);
+
+/**
+ * @brief Load the owners of a snapshot file into the (empty) ring.
+ * @param path file to read; a missing file counts as an empty snapshot
+ * @return number of owners loaded, or -1 if the file is unreadable or corrupt
+ * Why we made it: Each Pokedex is stored sorted, so it's rebuilt with buildBalancedTree in O(n),
+ * no per-node search or insert.
+ */
+long loadSnapshot(const char *path);
+
+/**
+ * @brief Create an owner whose Pokedex holds exactly the given sorted IDs.
+ * @param ownerName the dynamically allocated name (the owner keeps it on success, the caller on failure)
+ * @param ids species IDs, strictly ascending, each in 1..MAX_POKEMON_ID
+ * @param count how many IDs
+ * @return the new owner (not linked into the ring yet), or NULL if allocation failed
+ */
+OwnerNode *restoreOwner(char *ownerName, const unsigned char *ids, int count);
+
+/**asks for a file when no --snapshot path was given, saves, and prints the result*/
+void saveSnapshotMenu(void);
+
+/* ------------------------------------------------------------
+   17) Operation Journal
+   ------------------------------------------------------------ */
+
+// Journal file (<snapshot>.journal) layout:
+//   "PKJL" 1          magic and format version
+//   generation        the snapshot generation these records go on top of
+//   records, each one op byte followed by its fields:
+//     'N' name starter   'A' name id   'R' name id   'E' name id
+//     'D' name           'M' name name 'S'
+//     'V' name toFinal   (evolve all)   'B' name ids   (add many)   'X' name ids (release many)
+//   where name is a uint32 length and the bytes, starter/id/toFinal are one byte,
+//   and ids is OWNED_WORDS uint32 words, one bit per species ID.
+
+/**
+ * @brief Open (or create) the journal next to the snapshot and replay it onto the loaded owners.
+ * @param snapshot the --snapshot path
+ * @return number of records replayed, or -1 if the journal is corrupt or can't be opened
+ * Why we made it: Owners changed since the last save come back after a crash.
+ * A journal left over from an older snapshot is dropped, a record cut off by a crash is truncated away.
+ * A journal with a bad header or a newer generation than the snapshot is left alone and startup fails,
+ * so committed records are never thrown away without a word.
+ */
+long openJournal(const char *snapshot);
+
+/**
+ * @brief Append one operation to the journal buffer (nothing happens when no journal is open or while replaying).
+ * @param op record type ('N', 'A', 'R', 'E', 'D', 'M', 'S' or 'V'; 'B' and 'X' go through journalRecordIds)
+ * @param name owner the operation is on (NULL for 'S')
+ * @param otherName second owner for 'M', NULL otherwise
+ * @param value starter, species ID or flag for the record types that have one
+ * Why we made it: Every mutating apply* function logs through here; records are group-committed,
+ * not fsynced one by one.
+ */
+void journalRecord(char op, const char *name, const char *otherName, int value);
+
+/**appends a record that carries a set of species IDs (OWNED_WORDS words) for one owner, like journalRecord*/
+void journalRecordIds(char op, const char *name, const uint32_t *ids);
+
+/**
+ * @brief Write the buffered records to the journal and fsync it.
+ * Why we made it: Called when the buffer or the commit window fills up, before blocking on input,
+ * and at exit, so a crash loses at most one commit window.
+ */
+void journalCommit(void);
+
+/**commits once JOURNAL_COMMIT_BYTES are pending or JOURNAL_COMMIT_NANOS have passed since the last commit; every record type ends with this*/
+void journalCommitIfDue(void);
+
+/**commits what's pending and closes the journal*/
+void closeJournal(void);
+
+/**writes all len bytes to fd, retrying short writes, returns 1 on success*/
+int writeAll(int fd, const char *data, size_t len);
+
+/**empties the journal and writes a fresh header for the given snapshot generation, returns 1 on success*/
+int resetJournal(uint32_t generation);
+
+/**monotonic clock in nanoseconds, for the journal's commit window*/
+long journalClock(void);
+
+/**appends raw bytes to the pending records, committing first when they don't fit*/
+void journalAppend(const void *data, size_t len);
+
+/**appends a name field: its length as a little-endian uint32, then the bytes*/
+void journalAppendName(const char *name);
+
+/**reads a name field at *cursor into a NUL-terminated scratch buffer (grown as needed), returns 0 if it's cut off*/
+int journalReadName(const unsigned char **cursor, const unsigned char *end, char **scratch, size_t *scratchSize);
+
+/**
+ * @brief Apply journal records through the apply* functions.
+ * @param data first record
+ * @param end end of the journal data
+ * @param goodEnd set past the last record that was applied
+ * @return how many records were applied, or -1 for a record that doesn't fit the owners
+ */
+long replayJournalRecords(const unsigned char *data, const unsigned char *end, const unsigned char **goodEnd);
+
+/* ------------------------------------------------------------
+   18) Compact Pokedex Storage
+   ------------------------------------------------------------ */
+
+/**
+ * @brief Build a compact Pokedex from species IDs.
+ * @param out the Pokedex to fill (its old nodes are not freed)
+ * @param ids species IDs, strictly ascending
+ * @param count how many IDs (at most MAX_POKEMON_ID)
+ * @return 1 on success, 0 if allocation failed (out is left empty)
+ * Why we made it: 3 bytes per node in one allocation, instead of a 32-byte PokemonNode per Pokemon.
+ * The same balanced shape as buildBalancedTree, in O(count).
+ */
+int buildCompactPokedex(CompactPokedex *out, const uint8_t *ids, int count);
+
+/**builds a compact copy of a PokemonNode tree, returns 1 on success*/
+int compactFromTree(CompactPokedex *out, PokemonNode *root);
+
+/**returns 1 if the compact Pokedex holds this species, walking down from nodes[0]*/
+int compactContains(const CompactPokedex *compact, int id);
+
+/**writes the compact Pokedex's IDs into out in ascending order (in-order walk), returns how many*/
+int compactIds(const CompactPokedex *compact, uint8_t *out);
+
+/**
+ * @brief Expand a compact Pokedex back into a balanced PokemonNode tree.
+ * @param compact the compact Pokedex
+ * @param arena arena to allocate the nodes from
+ * @return the new tree's root (NULL if it's empty or allocation failed)
+ */
+PokemonNode *compactToTree(const CompactPokedex *compact, PokemonArena *arena);
+
+/**frees the node array and leaves the compact Pokedex empty*/
+void freeCompactPokedex(CompactPokedex *compact);
+
+/* ------------------------------------------------------------
+   19) Tournaments
+   ------------------------------------------------------------ */
+
+/**
+ * @brief Fight score (attack * 1.5 + hp * 1.2) of every species in ids, in one vector pass.
+ * @param ids species IDs
+ * @param count how many IDs
+ * @param scores out: scores[i] is the score of ids[i]
+ * Why we made it: A tournament needs every score at once. AVX2 builds gather 8 IDs' stats
+ * from the species table per step, SSE2 builds convert 4 at a time, anything else uses speciesScore.
+ * All paths multiply and add separately, so they give exactly the scores a fight prints.
+ */
+void scoreSpecies(const uint8_t *ids, int count, double *scores);
+
+/**compares two TournamentEntry: higher score first, then lower ID*/
+int compareTournamentEntries(const void *a, const void *b);
+
+/**
+ * @brief Full round-robin between all of an owner's Pokemon, printed as a ranking.
+ * @param owner pointer to the Owner
+ * Why we made it: Every pair fights once and the higher score wins (equal scores draw), so a
+ * Pokemon's wins are just the number of Pokemon scoring below it. One sort by score gives the
+ * whole table, instead of n*(n-1)/2 fights.
+ */
+void pokemonTournament(OwnerNode *owner);
+
+/* ------------------------------------------------------------
+   20) League
+   ------------------------------------------------------------ */
+
+/**returns the sum of the fight scores of the owner's LEAGUE_TEAM_SIZE best Pokemon (all of them if fewer)*/
+double teamStrength(const OwnerNode *owner);
+
+/**compares two LeagueEntry: higher strength first, then owner name*/
+int compareLeagueEntries(const void *a, const void *b);
+
+/**thread body: fills in the strengths of one LeagueWorker's owners and sorts them, arg is the LeagueWorker*/
+void *leagueWorker(void *arg);
+
+/**threads a league of count owners is split between: one per LEAGUE_OWNERS_PER_THREAD owners, capped by the CPUs online and LEAGUE_MAX_THREADS*/
+int leagueThreadCount(int count);
+
+/**
+ * @brief Score and sort entries[0, count) in threadCount shares, then merge them into standings.
+ * @param entries owners to rank, each entry's owner set; strengths are filled in and each share is sorted in place
+ * @param standings receives all count entries, best first
+ * @param threadCount shares to split into, clamped to [1, min(count, LEAGUE_MAX_THREADS)]
+ * Why we made it: runLeague picks the thread count from the machine; the benchmark forces
+ * several threads and one thread on the same owners and checks they rank them the same.
+ */
+void rankLeague(LeagueEntry *entries, LeagueEntry *standings, int count, int threadCount);
+
+/**
+ * @brief Every owner's best team against every other owner's, printed as standings.
+ * Why we made it: With 100k owners there are billions of pairings. The owners are copied
+ * into an array and split between threads, and each thread scores and sorts its share.
+ * The calling thread only waits for them and merges the sorted shares. As in a tournament,
+ * the stronger team wins and equal strengths draw, so wins come straight from the standings.
+ */
+void runLeague(void);
+
 // Array of Pokemon data
 static const PokemonData pokedex[] = {
     {1, "Bulbasaur", GRASS, 45, 49, CAN_EVOLVE},